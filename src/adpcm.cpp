@@ -0,0 +1,147 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
+
+#include "adpcm.hpp"
+
+// NOLINTBEGIN(*-magic-numbers)
+namespace {
+	// Pairs of 11-bit fixed point predictors, covering silence, first order and the usual second order filters
+	constexpr std::array<int16_t, 16> previewCoefficients{
+			0, 0,
+			1920, 0,
+			3680, -1664,
+			3136, -1760,
+			3904, -1920,
+			2048, 0,
+			4032, -1984,
+			1024, 0,
+	};
+
+	constexpr int32_t maxScaleShift = 12;
+
+	/// Picks the predictor that best follows the source samples, and the smallest scale that fits its residuals
+	std::pair<size_t, int32_t> choosePreviewFrame(const std::span<const int16_t> frame, const int32_t hist1, const int32_t hist2) noexcept{
+		size_t best_predictor = 0;
+		int64_t best_residual = std::numeric_limits<int64_t>::max();
+		for(size_t predictor = 0; predictor < previewCoefficients.size() / 2; predictor++){
+			const int32_t coef1 = previewCoefficients[predictor * 2]; // NOLINT(*-pro-bounds-constant-array-index)
+			const int32_t coef2 = previewCoefficients[(predictor * 2) + 1]; // NOLINT(*-pro-bounds-constant-array-index)
+			int32_t h1 = hist1;
+			int32_t h2 = hist2;
+			int64_t max_residual = 0;
+			for(const int16_t sample: frame){
+				const int64_t residual = (int64_t{sample} << 11) - ((coef1 * h1) + (coef2 * h2));
+				max_residual = std::max(max_residual, residual < 0 ? -residual : residual);
+				h2 = h1;
+				h1 = sample;
+			}
+			if(max_residual < best_residual){
+				best_residual = max_residual;
+				best_predictor = predictor;
+			}
+		}
+
+		int32_t shift = 0;
+		while(shift < maxScaleShift && best_residual > (int64_t{7} << (11 + shift))){
+			shift++;
+		}
+		return {best_predictor, shift};
+	}
+} // namespace
+
+void DatPak::encodeAdpcmPreview(const std::span<const int16_t> samples, const std::span<uint8_t> adpcm, std::array<int16_t, 16> &coefficients) noexcept{
+	coefficients = previewCoefficients;
+
+	int32_t hist1 = 0;
+	int32_t hist2 = 0;
+	std::array<int16_t, samplesPerFrame> frameSamples{};
+	for(size_t frame = 0, sample = 0; frame + bytesPerFrame <= adpcm.size(); frame += bytesPerFrame, sample += samplesPerFrame){
+		// The last frame is padded with silence
+		const size_t count = sample < samples.size() ? std::min(samplesPerFrame, samples.size() - sample) : 0;
+		frameSamples.fill(0);
+		std::copy_n(samples.begin() + static_cast<std::ptrdiff_t>(sample), count, frameSamples.begin());
+
+		const auto [predictor, shift] = choosePreviewFrame(frameSamples, hist1, hist2);
+		const int32_t coef1 = previewCoefficients[predictor * 2]; // NOLINT(*-pro-bounds-constant-array-index)
+		const int32_t coef2 = previewCoefficients[(predictor * 2) + 1]; // NOLINT(*-pro-bounds-constant-array-index)
+		const int64_t step = int64_t{1} << (11 + shift);
+
+		const auto out = adpcm.subspan(frame, bytesPerFrame);
+		std::fill(out.begin(), out.end(), uint8_t{0});
+		out[0] = static_cast<uint8_t>((predictor << 4U) | static_cast<uint32_t>(shift));
+
+		for(size_t nibble = 0; nibble < samplesPerFrame; nibble++){
+			// Quantise against the decoded history, so errors don't build up
+			const int32_t prediction = (coef1 * hist1) + (coef2 * hist2);
+			const int64_t residual = (int64_t{frameSamples[nibble]} << 11) - prediction; // NOLINT(*-pro-bounds-constant-array-index)
+			const int64_t rounded = residual < 0 ? residual - (step / 2) : residual + (step / 2);
+			const auto delta = static_cast<int32_t>(std::clamp<int64_t>(rounded / step, -8, 7));
+
+			const int32_t decoded = std::clamp(((delta << shift << 11) + 1024 + prediction) >> 11,
+			                                   int32_t{std::numeric_limits<int16_t>::min()}, int32_t{std::numeric_limits<int16_t>::max()});
+			hist2 = hist1;
+			hist1 = decoded;
+
+			const auto bits = static_cast<uint8_t>(static_cast<uint32_t>(delta) & 0xFU);
+			out[1 + (nibble / 2)] |= nibble % 2 == 0 ? static_cast<uint8_t>(bits << 4U) : bits;
+		}
+	}
+}
+
+void DatPak::decodeAdpcm(const std::span<const uint8_t> adpcm, const std::array<int16_t, 16> &coefficients, const std::span<int16_t> samples) noexcept{
+	int32_t hist1 = 0;
+	int32_t hist2 = 0;
+	size_t sample = 0;
+	for(size_t frame = 0; frame + bytesPerFrame <= adpcm.size() && sample < samples.size(); frame += bytesPerFrame){
+		const uint8_t header = adpcm[frame];
+		const int32_t scale = 1 << (header & 0xFU);
+		const size_t coefIndex = (header >> 4U) & 0x7U;
+		const int32_t coef1 = coefficients[coefIndex * 2]; // NOLINT(*-pro-bounds-constant-array-index)
+		const int32_t coef2 = coefficients[(coefIndex * 2) + 1]; // NOLINT(*-pro-bounds-constant-array-index)
+
+		for(size_t nibble = 0; nibble < samplesPerFrame && sample < samples.size(); nibble++, sample++){
+			const uint8_t byte = adpcm[frame + 1 + (nibble / 2)];
+			// High nibble first, sign extended from 4 bits
+			const int32_t value = (nibble % 2 == 0 ? byte >> 4U : byte & 0xFU) ^ 0x8;
+			const int32_t delta = value - 8;
+
+			int32_t decoded = ((delta * scale) << 11) + 1024 + (coef1 * hist1) + (coef2 * hist2);
+			decoded = std::clamp(decoded >> 11, int32_t{std::numeric_limits<int16_t>::min()}, int32_t{std::numeric_limits<int16_t>::max()});
+
+			samples[sample] = static_cast<int16_t>(decoded);
+			hist2 = hist1;
+			hist1 = decoded;
+		}
+	}
+	// Anything the ADPCM data doesn't cover decodes to silence
+	std::fill(samples.begin() + static_cast<std::ptrdiff_t>(sample), samples.end(), int16_t{0});
+}
+// NOLINTEND(*-magic-numbers)
+
+DatPak::SampleError DatPak::compareSamples(const std::span<const int16_t> reference, const std::span<const int16_t> decoded) noexcept{
+	const size_t count = std::min(reference.size(), decoded.size());
+
+	// Accumulated in doubles, which SSE2 can vectorise once -Ofast lets the sums be reordered, unlike 64-bit integers.
+	// Every square is below 2^33, so it's exact, and rounding in the sums doesn't matter at the precision an SNR is reported
+	double signal = 0;
+	double noise = 0;
+	double peak = 0;
+	for(size_t i = 0; i < count; i++){
+		const double expected = reference[i];
+		const double error = decoded[i] - expected;
+		signal += expected * expected;
+		noise += error * error;
+		peak = std::max(peak, std::abs(error));
+	}
+
+	if(noise == 0){
+		return {.snr = std::numeric_limits<double>::infinity(), .peak = 0};
+	}
+	constexpr double decibels = 10.0;
+	return {
+			.snr = decibels * std::log10(signal / noise),
+			.peak = static_cast<uint32_t>(peak)
+	};
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <span>
+
+namespace DatPak {
+	constexpr size_t samplesPerFrame = 14;
+	constexpr size_t bytesPerFrame = 8;
+
+	/** Encodes with a fixed set of predictors, choosing the predictor and scale for each frame in a single greedy pass.
+	 *  Much faster than DspTool's encode, at the cost of quality. The predictors used are written to coefficients.
+	 */
+	void encodeAdpcmPreview(std::span<const int16_t> samples, std::span<uint8_t> adpcm, std::array<int16_t, 16> &coefficients) noexcept;
+
+	/// Decodes GameCube DSP ADPCM frames, starting from an empty history
+	void decodeAdpcm(std::span<const uint8_t> adpcm, const std::array<int16_t, 16> &coefficients, std::span<int16_t> samples) noexcept;
+
+	struct SampleError{
+		double snr; // In dB, infinite when both match exactly
+		uint32_t peak;
+	};
+
+	/// Compares decoded samples against the reference they were encoded from
+	SampleError compareSamples(std::span<const int16_t> reference, std::span<const int16_t> decoded) noexcept;
+} // namespace DatPak
@@ -0,0 +1,117 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <tuple>
+
+namespace DatPak::BigEndian {
+	template<std::integral T>
+	constexpr T toBig(const T value) noexcept{
+		if constexpr (std::endian::native == std::endian::little && sizeof(T) > 1) {
+			return std::byteswap(value);
+		} else {
+			return value;
+		}
+	}
+
+	template<std::integral T>
+	void store(const std::span<uint8_t> out, const size_t offset, const T value) noexcept{
+		const T big = toBig(value);
+		std::memcpy(out.subspan(offset, sizeof(T)).data(), &big, sizeof(T));
+	}
+
+	/// Swaps the whole array in one go, which compiles down to a handful of vector shuffles
+	template<std::integral T, size_t N>
+	void store(const std::span<uint8_t> out, const size_t offset, const std::array<T, N> &values) noexcept{
+		std::array<T, N> big{};
+		std::ranges::transform(values, big.begin(), toBig<T>);
+		std::memcpy(out.subspan(offset, sizeof(big)).data(), big.data(), sizeof(big));
+	}
+
+	template<std::integral T>
+	T load(const std::span<const uint8_t> in, const size_t offset) noexcept{
+		T big{};
+		std::memcpy(&big, in.subspan(offset, sizeof(T)).data(), sizeof(T));
+		return toBig(big);
+	}
+
+	template<std::integral T, size_t N>
+	void load(const std::span<const uint8_t> in, const size_t offset, std::array<T, N> &values) noexcept{
+		std::memcpy(values.data(), in.subspan(offset, sizeof(values)).data(), sizeof(values));
+		std::ranges::transform(values, values.begin(), toBig<T>);
+	}
+
+	template<typename>
+	struct MemberTraits;
+
+	template<typename C, typename M>
+	struct MemberTraits<M C::*>{
+		using Class = C;
+		using Type = M;
+	};
+
+	/// A member of a record and where it's stored within that record
+	template<auto Member, size_t Offset>
+	struct Field{
+		using Record = typename MemberTraits<decltype(Member)>::Class;
+		using Type = typename MemberTraits<decltype(Member)>::Type;
+
+		static constexpr size_t offset = Offset;
+		static constexpr size_t size = sizeof(Type);
+
+		static void write(const std::span<uint8_t> out, const Record &record) noexcept{
+			store(out, Offset, record.*Member);
+		}
+
+		static void read(const std::span<const uint8_t> in, Record &record) noexcept{
+			if constexpr (std::integral<Type>) {
+				record.*Member = load<Type>(in, Offset);
+			} else {
+				load(in, Offset, record.*Member);
+			}
+		}
+	};
+
+	/** The on-disk layout of a record. Fields are listed in the order they're stored,
+	 *  anything not covered by a field is left as it was in the output.
+	 */
+	template<size_t Size, typename... Fields>
+	struct RecordLayout{
+		static constexpr size_t size = Size;
+
+		static consteval bool fieldsInOrder(){
+			constexpr std::array offsets{Fields::offset...};
+			constexpr std::array sizes{Fields::size...};
+			for(size_t i = 0; i < offsets.size(); i++){
+				const size_t end = offsets[i] + sizes[i];
+				if(end > Size || (i + 1 < offsets.size() && end > offsets[i + 1])){
+					return false;
+				}
+			}
+			return true;
+		}
+		static_assert(fieldsInOrder(), "Fields overlap or don't fit in the record");
+
+		template<size_t I>
+		using field = std::tuple_element_t<I, std::tuple<Fields...>>;
+
+		template<typename Record>
+		static void write(const std::span<uint8_t> out, const Record &record) noexcept{
+			const auto bytes = out.first(Size);
+			(Fields::write(bytes, record), ...);
+		}
+
+		template<typename Record>
+		static Record read(const std::span<const uint8_t> in) noexcept{
+			const auto bytes = in.first(Size);
+			Record record{};
+			(Fields::read(bytes, record), ...);
+			return record;
+		}
+	};
+} // namespace DatPak::BigEndian
@@ -0,0 +1,163 @@
+#include <algorithm>
+#include <fstream>
+#include <istream>
+#include <map>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <fmt/format.h>
+#include <fmt/ostream.h>
+
+#include "buildReport.hpp"
+
+namespace {
+	constexpr std::string_view reportHeader = "DatPak report 1";
+
+	std::string_view tierName(const DatPak::Quality tier) noexcept{
+		return tier == DatPak::Quality::Preview ? "preview" : "final";
+	}
+} // namespace
+
+void DatPak::BuildReport::write(std::ostream &out) const{
+	fmt::print(out, "{}\n", reportHeader);
+	fmt::print(out, "shard {}/{}\n", Slice.index, Slice.count);
+	fmt::print(out, "config-errors {}\nerrors {}\nwarnings {}\ngenerated {}\nskipped {}\nfailed-verification {}\npreviews {}\n",
+	           ConfigErrors, Errors, Warnings, Generated, Skipped, FailedVerification, Previews);
+	for(const auto &archive: Archives){
+		// The path goes last, so it can contain spaces
+		fmt::print(out, "archive {} {} {:016x} {} {}\n",
+		           tierName(archive.Tier), archive.Built ? "built" : "failed", archive.Hash, archive.Size, archive.Output);
+	}
+}
+
+DatPak::BuildReport DatPak::BuildReport::read(std::istream &in){
+	std::string line;
+	if(!std::getline(in, line) || line != reportHeader){
+		throw std::runtime_error("Not a DatPak build report");
+	}
+
+	BuildReport result;
+	const std::map<std::string_view, size_t *> counters{
+			{"config-errors", &result.ConfigErrors},
+			{"errors", &result.Errors},
+			{"warnings", &result.Warnings},
+			{"generated", &result.Generated},
+			{"skipped", &result.Skipped},
+			{"failed-verification", &result.FailedVerification},
+			{"previews", &result.Previews},
+	};
+	while(std::getline(in, line)){
+		std::istringstream fields(line);
+		std::string key;
+		fields >> key;
+		if(key.empty()){
+			continue;
+		}
+		if(key == "shard"){
+			std::string shard;
+			fields >> shard;
+			result.Slice = parseShard(shard);
+		}else if(key == "archive"){
+			ArchiveRecord archive;
+			std::string tier;
+			std::string built;
+			fields >> tier >> built >> std::hex >> archive.Hash >> std::dec >> archive.Size >> std::ws;
+			std::getline(fields, archive.Output);
+			if(!fields && !fields.eof()){
+				throw std::runtime_error(fmt::format("Invalid archive line in report: {}", line));
+			}
+			archive.Tier = tier == "preview" ? Quality::Preview : Quality::Final;
+			archive.Built = built == "built";
+			result.Archives.emplace_back(std::move(archive));
+		}else if(const auto counter = counters.find(key); counter != counters.end()){
+			fields >> *counter->second;
+		}else{
+			throw std::runtime_error(fmt::format("Unknown line in report: {}", line));
+		}
+	}
+	return result;
+}
+
+uint64_t DatPak::fnv1a(const std::span<const uint8_t> data) noexcept{
+	constexpr uint64_t offsetBasis = 0xCBF29CE484222325;
+	constexpr uint64_t prime = 0x100000001B3;
+	uint64_t hash = offsetBasis;
+	for(const uint8_t byte: data){
+		hash = (hash ^ byte) * prime;
+	}
+	return hash;
+}
+
+void DatPak::hashArchive(const fs::path &file, ArchiveRecord &record){
+	std::ifstream in(file, std::ios_base::in | std::ios_base::binary);
+	const std::vector<uint8_t> data{std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>()};
+	record.Size = data.size();
+	record.Hash = fnv1a(data);
+}
+
+bool DatPak::mergeReports(const std::span<const BuildReport> reports, BuildReport &merged, LogBuffer &report){
+	bool consistent = true;
+	if(reports.empty()){
+		return consistent;
+	}
+
+	const uint32_t shardCount = reports.front().Slice.count;
+	std::vector<bool> seen(shardCount);
+	std::map<std::string, ArchiveRecord> archives;
+	for(const auto &shard: reports){
+		if(shard.Slice.count != shardCount){
+			report.print(Severity::Error, errorColors, "Shard {}/{} is from a build split {} ways\n",
+			             shard.Slice.index, shard.Slice.count, shardCount);
+			consistent = false;
+			continue;
+		}
+		if(seen[shard.Slice.index - 1]){
+			report.print(Severity::Error, errorColors, "Shard {}/{} was given more than once\n", shard.Slice.index, shardCount);
+			consistent = false;
+			continue;
+		}
+		seen[shard.Slice.index - 1] = true;
+
+		// Config errors are found by every shard, so they're only counted once
+		if(shard.ConfigErrors != reports.front().ConfigErrors){
+			report.print(Severity::Error, errorColors, "Shard {}/{} found {} problems in the configs where shard {}/{} found {}, were they given the same configs?\n",
+			             shard.Slice.index, shardCount, shard.ConfigErrors, reports.front().Slice.index, shardCount, reports.front().ConfigErrors);
+			consistent = false;
+		}
+		merged.ConfigErrors = std::max(merged.ConfigErrors, shard.ConfigErrors);
+
+		merged.Errors += shard.Errors;
+		merged.Warnings += shard.Warnings;
+		merged.Generated += shard.Generated;
+		merged.Skipped += shard.Skipped;
+		merged.FailedVerification += shard.FailedVerification;
+		merged.Previews += shard.Previews;
+
+		for(const auto &archive: shard.Archives){
+			const auto [existing, added] = archives.emplace(archive.Output, archive);
+			if(added){
+				continue;
+			}
+			if(existing->second.Hash != archive.Hash || existing->second.Size != archive.Size){
+				report.print(Severity::Error, errorColors, "{} was built differently by two shards ({:016x} and {:016x})\n",
+				             archive.Output, existing->second.Hash, archive.Hash);
+				consistent = false;
+			}else{
+				report.print(Severity::Debug, "{} was built by more than one shard\n", archive.Output);
+			}
+		}
+	}
+
+	for(uint32_t i = 0; i < shardCount; i++){
+		if(!seen[i]){
+			report.print(Severity::Error, errorColors, "Shard {}/{} is missing\n", i + 1, shardCount);
+			consistent = false;
+		}
+	}
+
+	merged.Slice = {.index = 1, .count = 1};
+	for(auto &[output, archive]: archives){
+		merged.Archives.emplace_back(std::move(archive));
+	}
+	return consistent;
+}
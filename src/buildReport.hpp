@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <iosfwd>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "gcaxArchive.hpp"
+#include "jobGraph.hpp"
+#include "log.hpp"
+
+namespace fs = std::filesystem;
+
+namespace DatPak {
+	/// One archive in a build report
+	struct ArchiveRecord{
+		std::string Output; // As given by outputKey
+		uint64_t Size = 0;
+		uint64_t Hash = 0; // FNV-1a of the whole file
+		Quality Tier = Quality::Final;
+		bool Built = false; // False if building it failed
+	};
+
+	/** What one worker built, written with --report so the shards of a build can be merged afterwards.
+	 *  Only plain text is written, so reports can be compared and archived by the CI.
+	 */
+	struct BuildReport{
+		Shard Slice{.index = 1, .count = 1};
+		size_t ConfigErrors = 0; // The same for every shard, as they all read every config
+		size_t Errors = 0;
+		size_t Warnings = 0;
+		size_t Generated = 0;
+		size_t Skipped = 0;
+		size_t FailedVerification = 0;
+		size_t Previews = 0;
+		std::vector<ArchiveRecord> Archives;
+
+		void write(std::ostream &out) const;
+
+		[[nodiscard]] static BuildReport read(std::istream &in);
+	};
+
+	uint64_t fnv1a(std::span<const uint8_t> data) noexcept;
+
+	/// Fills in the size and hash from an archive that's already on disk
+	void hashArchive(const fs::path &file, ArchiveRecord &record);
+
+	/** Combines the reports of every shard into one. Reports a missing or repeated shard, shards that disagree
+	 *  about the configs, and any archive that two shards built differently, returning false if anything didn't line up.
+	 */
+	bool mergeReports(std::span<const BuildReport> reports, BuildReport &merged, LogBuffer &report);
+} // namespace DatPak
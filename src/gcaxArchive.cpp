@@ -1,9 +1,11 @@
+#include <algorithm>
 #include <chrono>
 #include <dsptool.h>
 #include <fstream>
 #include <istream>
 #include <limits>
 #include <memory>
+#include <optional>
 #include <span>
 #include <spanstream>
 #include <utility>
@@ -11,7 +13,9 @@
 #include <fmt/color.h>
 #include <fmt/core.h>
 
+#include "adpcm.hpp"
 #include "gcaxArchive.hpp"
+#include "silence.hpp"
 #include "state.hpp"
 
 namespace DatPak {
@@ -26,33 +30,64 @@ namespace DatPak {
 
 } // namespace DatPak
 
-void DatPak::GCAXArchive::WriteFile([[maybe_unused]] const fs::path &config) const{
+// NOLINTBEGIN(*-magic-numbers)
+namespace {
+	consteval uint32_t templateWord(const size_t offset){
+		uint32_t word = 0;
+		for(size_t i = 0; i < sizeof(word); i++){
+			word = (word << 8U) | DatPak::templateMainBody.at(offset + i);
+		}
+		return word;
+	}
+
+	// The template is a real archive, so its header has to agree with the field offsets we patch
+	using DatPak::DtpkHeaderLayout;
+	static_assert(templateWord(0x0) == 0x67636178 && templateWord(0x4) == 0x4454504B, "Main body template should start with gcaxDTPK");
+	static_assert(DtpkHeaderLayout::size <= DatPak::templateMainBody.size());
+	static_assert(templateWord(DtpkHeaderLayout::field<1>::offset) == templateWord(DtpkHeaderLayout::field<6>::offset) + 0x20,
+	              "spec1 should be end_of_info + 0x20");
+	static_assert(templateWord(DtpkHeaderLayout::field<3>::offset) == size_t{1} << (DatPak::findMsbPosition(templateWord(DtpkHeaderLayout::field<6>::offset)) + 1),
+	              "Audio data should start at the power of two after end_of_info");
+	static_assert(templateWord(DtpkHeaderLayout::field<4>::offset) < templateWord(DtpkHeaderLayout::field<5>::offset)
+	              && templateWord(DtpkHeaderLayout::field<5>::offset) < templateWord(DtpkHeaderLayout::field<6>::offset),
+	              "Audio info, file entries and end_of_info should be in order");
+	static_assert(DatPak::AudioInfoHeaderLayout::size == DatPak::templateDataHeader.size());
+	static_assert(DatPak::AudioInfoRecordLayout::size == DatPak::templateDataStruct.size());
+} // namespace
+// NOLINTEND(*-magic-numbers)
+
+bool DatPak::GCAXArchive::WriteFile([[maybe_unused]] const fs::path &config, LogBuffer &report) const{
 	auto warnings = Warnings;
+	bool written = true;
+	if(Tier == Quality::Preview){
+		report.print(Severity::Warning, warningColors, "Preview quality, not for release: {}\n", fs::absolute(FilePath).string());
+	}
 	if(warnings != 0U){
-		const std::scoped_lock writeLock{programState.printLock};
-		fmt::print(warningColors,
-		           "Writing file with issues: {}\n\t0x{:X}\t0x{:X}\n",
-		           fs::absolute(FilePath).string(), spec1, spec2
+		report.print(Severity::Warning, warningColors,
+		             "Writing file with issues: {}\n\t0x{:X}\t0x{:X}\n",
+		             fs::absolute(FilePath).string(), spec1, spec2
 		);
-	}else if(programState.verbose() >= 1){
-		const std::scoped_lock writeLock{programState.printLock};
-		fmt::print("Writing file: {}\n\t0x{:X}, 0x{:X}\n", fs::absolute(FilePath).string(), spec1, spec2);
+	}else{
+		report.print(Severity::Info, "Writing file: {}\n\t0x{:X}, 0x{:X}\n", fs::absolute(FilePath).string(), spec1, spec2);
 	}
 	try{
 		using output_stream = std::ofstream;
 		output_stream out(FilePath, std::ios_base::binary | std::ios_base::out);
 		out.exceptions(output_stream::badbit | output_stream::failbit);
 		out.write(reinterpret_cast<const char *>(Dat.data()), static_cast<std::streamsize>(Dat.size())); //NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+		out.close(); // Closed here so a failed final flush throws, rather than being lost in the destructor
 	}catch(std::ios_base::failure &e){
-		fmt::print(errorColors, "Error writing file: {}", e.what());
+		report.print(Severity::Error, errorColors, "Error writing file: {}\n", e.what());
 		warnings++;
+		written = false;
 	}catch(...){
-		fmt::print(errorColors, "Unknown error writing file {}\n", fs::absolute(FilePath).string());
+		report.print(Severity::Error, errorColors, "Unknown error writing file {}\n", fs::absolute(FilePath).string());
 		warnings++;
+		written = false;
 	}
 	if(warnings != 0U){
 		using namespace std::chrono;
-		// Clear the modified time if there were any issues, so it will always be regenerated
+		// Clear the modified time if there were any issues, so it will always be regenerated. Previews are tracked by the settings stamp
 #ifndef _WIN32
 		constexpr auto emptyTime = fs::file_time_type::min();
 #else
@@ -62,6 +97,93 @@ void DatPak::GCAXArchive::WriteFile([[maybe_unused]] const fs::path &config) con
 		//constexpr fs::file_time_type emptyTime = time_point_cast<fs::file_time_type::duration>(std::chrono::sys_days{earliestTime});
 		fs::last_write_time(FilePath, emptyTime);
 	}
+	return written;
+}
+
+namespace {
+	/// Reads the samples from the actual data chunk, rather than assuming where it is like the build does
+	std::vector<int16_t> readPcmData(const fs::path &wavFilePath){
+		std::ifstream wavFile(wavFilePath, std::ios_base::in | std::ios_base::binary);
+		wavFile.seekg(0xC); // NOLINT(*-magic-numbers)
+
+		std::array<char, 4> chunkId{};
+		uint32_t chunkSize = 0;
+		while(wavFile.read(chunkId.data(), chunkId.size()) && wavFile.read(reinterpret_cast<char *>(&chunkSize), sizeof(chunkSize))){ // NOLINT(*-pro-type-reinterpret-cast)
+			if(std::string_view(chunkId.data(), chunkId.size()) == "data"){
+				std::vector<int16_t> samples(chunkSize / sizeof(int16_t));
+				wavFile.read(reinterpret_cast<char *>(samples.data()), static_cast<std::streamsize>(samples.size() * sizeof(int16_t))); // NOLINT(*-pro-type-reinterpret-cast)
+				samples.resize(static_cast<size_t>(wavFile.gcount()) / sizeof(int16_t));
+				return samples;
+			}
+			// Chunks are padded to an even size
+			wavFile.seekg(chunkSize + (chunkSize & 1U), std::ios_base::cur);
+		}
+		return {};
+	}
+} // namespace
+
+bool DatPak::GCAXArchive::verify(const ArchiveLayout &layout, const double minimumSnr, LogBuffer &report) const{
+	const std::span<const uint8_t> dat = Dat;
+	const auto file_entry_data = dat.subspan(layout.main_body_size + layout.audio_info_size + sizeof(uint32_t), layout.entries.size() * FileEntryLayout::size);
+	const auto audio_data = dat.subspan(layout.audio_data_start_offset, layout.audio_data_size);
+
+	struct EntryResult{
+		std::optional<SampleError> error;
+		std::string problem;
+	};
+	std::vector<EntryResult> results(layout.entries.size());
+
+	const auto verifyEntry = [&](const size_t i){
+		const auto &entry = layout.entries[i];
+		auto &result = results[i];
+		if(entry.substituted){
+			result.problem = "was replaced with an empty sound";
+			return;
+		}
+
+		const auto fileEntry = FileEntryLayout::read<FileEntry>(file_entry_data.subspan(i * FileEntryLayout::size));
+		const uint32_t sample_count = entry.sample_count;
+		if(fileEntry.data_size != getBytesForAdpcmBuffer(sample_count) || fileEntry.start_offset + fileEntry.data_size > audio_data.size()){
+			result.problem = fmt::format("has a stored size of 0x{:X} at 0x{:X}, which doesn't fit {} samples", fileEntry.data_size, fileEntry.start_offset, sample_count);
+			return;
+		}
+
+		std::vector<int16_t> decoded(sample_count);
+		decodeAdpcm(audio_data.subspan(fileEntry.start_offset, fileEntry.data_size), fileEntry.coefficient, decoded);
+
+		const auto reference = readPcmData(Files.at(static_cast<uint8_t>(i)));
+		const auto trimmed_reference = std::span(reference).subspan(std::min<size_t>(entry.first_sample, reference.size()));
+		result.error = compareSamples(trimmed_reference, decoded);
+		if(reference.size() != entry.data_length / 2){
+			result.problem = fmt::format("was built with {} samples from the header at 0x28, but its data chunk has {}", entry.data_length / 2, reference.size());
+		}else if(!(result.error->snr >= minimumSnr)){ // Written this way round so a NaN SNR fails too
+			result.problem = fmt::format("is below the minimum SNR of {:.1f} dB", minimumSnr);
+		}
+	};
+
+	// Every archive already has its own thread, so entries are checked one at a time to keep within the memory reservation
+	for(size_t i = 0; i < results.size(); i++){
+		verifyEntry(i);
+	}
+
+	bool passed = true;
+	double lowest_snr = std::numeric_limits<double>::infinity();
+	for(size_t i = 0; i < results.size(); i++){
+		const auto &[error, problem] = results[i];
+		if(!problem.empty()){
+			passed = false;
+			report.print(Severity::Error, errorColors, "Verification: ID '0x{:02X}' {}\n", i, problem);
+		}
+		if(error.has_value()){
+			lowest_snr = std::min(lowest_snr, error->snr);
+			report.print(problem.empty() ? Severity::Debug : Severity::Error,
+			             "\t0x{:02X}: {:.1f} dB SNR, peak error {}\n", i, error->snr, error->peak);
+		}
+	}
+	if(passed){
+		report.print(Severity::Info, okColors, "Verified {} entries in {}, lowest SNR {:.1f} dB\n", results.size(), FilePath.filename().string(), lowest_snr);
+	}
+	return passed;
 }
 
 const uint_fast8_t &DatPak::GCAXArchive::getWarningCount() const{
@@ -72,10 +194,9 @@ void DatPak::GCAXArchive::incrementWarning(){
 	Warnings++;
 }
 
-[[maybe_unused]] void DatPak::GCAXArchive::CompareFile(std::mutex &printLock, const fs::path &file) const{
+[[maybe_unused]] void DatPak::GCAXArchive::CompareFile(LogBuffer &report, const fs::path &file) const{
 	if(fs::status(file).type() != fs::file_type::regular){
-		const std::scoped_lock writeLock{printLock};
-		fmt::print(errorColors, "{} does not exist\n", file.string());
+		report.print(Severity::Error, errorColors, "{} does not exist\n", file.string());
 		return;
 	}
 
@@ -103,37 +224,29 @@ void DatPak::GCAXArchive::incrementWarning(){
 		if(val1 == val2){
 			continue;
 		}
-		const std::scoped_lock writeLock{printLock};
 		if(differences == 0){
-			fmt::print("{:^7}|{:^7}|{:^7}\n", "Address", "Created", "Compare");
+			report.print(Severity::Info, "{:^7}|{:^7}|{:^7}\n", "Address", "Created", "Compare");
 		}
 
-		fmt::print("{:^7X}|{:^7X}|{:^7X}\n", i, val1, val2);
+		report.print(Severity::Info, "{:^7X}|{:^7X}|{:^7X}\n", i, val1, val2);
 		differences++;
 	}
-	const std::scoped_lock writeLock{printLock};
 	if(differences == 0){
-		fmt::print("No differences detected.\n");
+		report.print(Severity::Info, "No differences detected.\n");
 	}else{
-		fmt::print("{} differences detected.\n", differences);
+		report.print(Severity::Info, "{} differences detected.\n", differences);
 	}
 }
 
-template<>
-void DatPak::PushBytes<std::string>(std::vector<uint8_t> &vector, const std::string &val){
-	vector.insert(vector.end(), val.begin(), val.end());
-}
-
-bool DatPak::verifyWavFormat(std::mutex &printLock, const fs::path &wavFilePath, std::ifstream &wavFile){
+bool DatPak::verifyWavFormat(LogBuffer &report, const fs::path &wavFilePath, std::ifstream &wavFile){
 	wavFile.seekg(0);
 	std::array<char, 4> buf{};
 	const std::string_view bufStr(buf.data(), 4);
 	wavFile.read(buf.data(), 4);
 	if(!bufStr.starts_with("RIFF")){
-		const std::scoped_lock writeLock{printLock};
-		fmt::print(errorColors,
-		           "Invalid WAV file: {}. Needs to be encoded in the RIFF format. Replacing with empty file.\n",
-		           wavFilePath.string());
+		report.print(Severity::Error, errorColors,
+		             "Invalid WAV file: {}. Needs to be encoded in the RIFF format. Replacing with empty file.\n",
+		             wavFilePath.string());
 		return false;
 	}
 
@@ -141,10 +254,9 @@ bool DatPak::verifyWavFormat(std::mutex &printLock, const fs::path &wavFilePath,
 
 	wavFile.read(buf.data(), 4);
 	if(!bufStr.starts_with("WAVE")){
-		const std::scoped_lock writeLock{printLock};
-		fmt::print(errorColors,
-		           "Invalid WAV file: {}. This is not a .wav file. Replacing with empty file.\n",
-		           wavFilePath.string());
+		report.print(Severity::Error, errorColors,
+		             "Invalid WAV file: {}. This is not a .wav file. Replacing with empty file.\n",
+		             wavFilePath.string());
 		return false;
 	}
 
@@ -153,19 +265,17 @@ bool DatPak::verifyWavFormat(std::mutex &printLock, const fs::path &wavFilePath,
 	uint16_t format{};
 	wavFile.read(reinterpret_cast<char *>(&format), 2); // NOLINT(*-pro-type-reinterpret-cast)
 	if(format != 1){
-		const std::scoped_lock writeLock{printLock};
-		fmt::print(errorColors,
-		           "Invalid WAV file: {}. This is not formatted using PCM. Replacing with empty file.\n",
-		           wavFilePath.string());
+		report.print(Severity::Error, errorColors,
+		             "Invalid WAV file: {}. This is not formatted using PCM. Replacing with empty file.\n",
+		             wavFilePath.string());
 		return false;
 	}
 
 	wavFile.read(reinterpret_cast<char *>(&format), 2); // NOLINT(*-pro-type-reinterpret-cast)
 	if(format != 1){
-		const std::scoped_lock writeLock{printLock};
-		fmt::print(errorColors,
-		           "Invalid WAV file: {}. This is not formatted as Mono. Replacing with empty file.\n",
-		           wavFilePath.string());
+		report.print(Severity::Error, errorColors,
+		             "Invalid WAV file: {}. This is not formatted as Mono. Replacing with empty file.\n",
+		             wavFilePath.string());
 		return false;
 	}
 
@@ -173,197 +283,266 @@ bool DatPak::verifyWavFormat(std::mutex &printLock, const fs::path &wavFilePath,
 }
 
 // NOLINTBEGIN(*-magic-numbers)
+size_t DatPak::ArchiveLayout::headerSize() const noexcept{
+	return main_body_size + audio_info_size + file_entry_size;
+}
+
+size_t DatPak::ArchiveLayout::entryPadding() const noexcept{
+	// audio_data starts with its own 0x20 byte header
+	size_t adpcm_size = 0x20;
+	for(const auto &entry: entries){
+		adpcm_size += entry.adpcm_byte_count;
+	}
+	return audio_data_size - adpcm_size;
+}
+
+size_t DatPak::ArchiveLayout::estimatePeakMemory() const noexcept{
+	size_t largest_entry = 0;
+	for(const auto &entry: entries){
+		// inWav is sized in samples rather than bytes, so it holds twice the data length.
+		// Verifying holds the decoded samples and the source's data chunk instead, which is no more than that
+		largest_entry = std::max<size_t>(largest_entry, entry.data_length * sizeof(int16_t));
+	}
+	// Entries are encoded straight into the Dat, so only one entry's PCM data is held next to it
+	return full_file_length + largest_entry;
+}
+
+DatPak::ArchiveLayout DatPak::GCAXArchive::plan(const fs::path &filePath, const std::map<uint8_t, fs::path> &files, LogBuffer &report){
+	if(files.empty()){
+		throw std::invalid_argument(fmt::format("List of files for archive \"{}\" was empty", filePath.string()));
+	}
+
+	ArchiveLayout layout{};
+	layout.file_count = files.size();
+
+	// Go to the last file in our (sorted) map and get the last ID that's specified
+	const int maxId = std::prev(files.end())->first;
+	layout.entries.reserve(static_cast<size_t>(maxId) + 1);
+
+	for(int i = 0; i <= maxId; i++){
+		const auto file = files.find(static_cast<uint8_t>(i));
+		std::unique_ptr<std::basic_istream<char>> wavFile;
+		EntryLayout entry{};
+
+		// Check and make sure this wav file is valid
+		if(file == files.end()){
+			report.print(Severity::Warning, warningColors,
+			             "Warning: File for ID '0x{:02X}' is empty, Replacing with empty file\n", i);
+			entry.substituted = true;
+		}else{
+			auto fileStream = std::make_unique<std::ifstream>(file->second, std::ios_base::in | std::ios_base::binary);
+			entry.substituted = !verifyWavFormat(report, file->second, *fileStream);
+			wavFile = std::move(fileStream);
+		}
+		if(entry.substituted){
+			// Replace the invalid wav file with an empty one
+			const std::span<const char> emptySpan = EmptySound;
+			wavFile = std::make_unique<std::ispanstream>(emptySpan);
+			layout.warnings++;
+		}
+
+		wavFile->seekg(0x18);
+		wavFile->read(reinterpret_cast<char *>(&entry.sample_rate), sizeof(entry.sample_rate)); // NOLINT(*-pro-type-reinterpret-cast)
+		if(entry.sample_rate != 44100){
+			report.print(Severity::Warning, warningColors,
+			             "Warning: File for ID '0x{:02X}' has a sample rate of {}. "
+			             "Game will play this sound at 44100 Hz leading to pitch issues\n",
+			             i, entry.sample_rate);
+			layout.warnings++;
+		}
+		wavFile->seekg(0x28);
+		wavFile->read(reinterpret_cast<char *>(&entry.data_length), sizeof(entry.data_length)); // NOLINT(*-pro-type-reinterpret-cast)
+
+		// Samples are stored as signed 16-bit, so the sample count is half of the available data
+		entry.sample_count = entry.data_length / 2;
+		entry.adpcm_byte_count = getBytesForAdpcmBuffer(entry.sample_count);
+		layout.entries.push_back(entry);
+	}
+
+	// ID, magic numbers and the index of the last file, then 10 bytes of file table per file, aligned to a 4-bit boundary
+	layout.main_body_size = align<4>(templateMainBody.size() + 8U + (layout.file_count * 10U));
+	layout.audio_info_size = templateDataHeader.size() + (layout.file_count * templateDataStruct.size());
+	layout.file_entry_size = sizeof(uint32_t) + (layout.entries.size() * FileEntryLayout::size);
+
+	// Get the end of our headers and align that to a 32-bit boundary
+	layout.end_of_info = align<32>(layout.headerSize());
+
+	// The audio data starts at the next power of two
+	layout.audio_data_start_offset = size_t{1} << (findMsbPosition(layout.end_of_info) + 1);
+
+	layout.placeEntries();
+	return layout;
+}
+
+void DatPak::ArchiveLayout::placeEntries() noexcept{
+	// audio_data starts with the gcaxPCMD header
+	size_t data_size = 0x20;
+	for(auto &entry: entries){
+		entry.offset = data_size;
+
+		// Each entry is aligned to an 8-bit boundary
+		data_size = align<8>(data_size + entry.adpcm_byte_count);
+	}
+
+	// This time we align to a 32-bit boundary
+	audio_data_size = align<32>(data_size);
+
+	// align the size of the full file to 256-bits
+	full_file_length = align<256>(audio_data_start_offset + audio_data_size);
+}
+
+void DatPak::GCAXArchive::trimSilence(ArchiveLayout &layout, const std::map<uint8_t, fs::path> &files, const SilenceOptions &options, LogBuffer &report){
+	for(size_t i = 0; i < layout.entries.size(); i++){
+		auto &entry = layout.entries[i];
+		if(entry.substituted){
+			continue;
+		}
+
+		// PCM data follows the data length
+		std::ifstream wavFile(files.at(static_cast<uint8_t>(i)), std::ios_base::in | std::ios_base::binary);
+		wavFile.seekg(0x2C);
+		std::vector<int16_t> inWav(entry.data_length / 2);
+		wavFile.read(reinterpret_cast<char *>(inWav.data()), static_cast<std::streamsize>(inWav.size() * sizeof(int16_t))); // NOLINT(*-pro-type-reinterpret-cast)
+
+		const auto range = findAudibleRange(inWav, entry.sample_rate, options);
+		entry.first_sample = range.first_sample;
+		entry.sample_count = range.sample_count;
+
+		const uint32_t adpcm_byte_count = getBytesForAdpcmBuffer(entry.sample_count);
+		const uint32_t saved = entry.adpcm_byte_count - adpcm_byte_count;
+		entry.adpcm_byte_count = adpcm_byte_count;
+		layout.trimmed_bytes += saved;
+		report.print(Severity::Info, "Trimmed {} samples of silence from ID '0x{:02X}', saving 0x{:X} bytes\n",
+		             (entry.data_length / 2) - entry.sample_count, i, saved);
+	}
+
+	// Headers don't change size, only the audio data after them moves
+	layout.placeEntries();
+}
+
 DatPak::GCAXArchive::GCAXArchive(
 		const uint16_t &datID,
 		fs::path &&filePath,
 		std::map<uint8_t, fs::path> &&files,
-		std::mutex &printLock
+		const ArchiveLayout &layout,
+		const Quality quality
 ) : ID(datID), FilePath(std::move(filePath)), Files(std::move(files)),
-    Warnings(0){
+    Warnings(layout.warnings), Tier(quality){
 	if(Files.empty()){
 		throw std::invalid_argument(fmt::format("List of files for archive \"{}\" was empty", FilePath.string()));
 	}
 
+	// Everything is written straight into the finished file, anything we don't write is zero padding
+	Dat.resize(layout.full_file_length);
+	const std::span<uint8_t> dat = Dat;
+
+	const auto file_count = static_cast<uint8_t>(layout.file_count);
+	const auto delta_file_count = static_cast<uint8_t>(file_count - 1);
+
 	// First, we copy the data template over
-	std::vector template_main_body(templateMainBody.begin(), templateMainBody.end());
-	const uint8_t file_count = Files.size();
-	const uint8_t delta_file_count = file_count - 1;
+	std::ranges::copy(templateMainBody, dat.begin());
+	auto sound_table = dat.subspan(templateMainBody.size(), layout.main_body_size - templateMainBody.size());
 
 	// Next, we add this archive's ID and index of the last file, plus some magic numbers
-	PushBytes(template_main_body, swap_to_big_endian(ID));
-	PushBytes(template_main_body, swap_to_big_endian<uint16_t>(0x08));
-	PushBytes(template_main_body, swap_to_big_endian(delta_file_count));
-	PushBytes(template_main_body, std::array<uint8_t, 3>{0});
+	SoundTableHeaderLayout::write(sound_table, SoundTableHeader{.id = ID, .unk = 0x08, .last_index = delta_file_count});
+	sound_table = sound_table.subspan(SoundTableHeaderLayout::size);
 
 	// Now add the offsets for each entry in the file table
 	// todo: comment this better
-	for(unsigned int i = 0, sndfile_table_offset = (file_count * 4U) + 0xCU;
+	for(uint32_t i = 0, sndfile_table_offset = (file_count * 4U) + 0xCU;
 	    i < file_count; i++, sndfile_table_offset += 6U){
-		PushBytes(template_main_body, swap_to_big_endian(sndfile_table_offset));
+		BigEndian::store(sound_table, i * sizeof(uint32_t), sndfile_table_offset);
 	}
+	sound_table = sound_table.subspan(file_count * sizeof(uint32_t));
 
 	// Add more magic numbers and the index for each file?
 	for(uint8_t i = 0; i < file_count; i++){
-		PushBytes(template_main_body, swap_to_big_endian<uint16_t>(0xC0DF));
-		template_main_body.push_back(i);
-		PushBytes(template_main_body, swap_to_big_endian<uint16_t>(0x7F80));
-		template_main_body.push_back(0xFF);
+		SoundTableRecordLayout::write(sound_table.subspan(i * SoundTableRecordLayout::size),
+		                              SoundTableRecord{.unk = 0xC0DF, .index = i, .unk2 = 0x7F80, .unk3 = 0xFF});
 	}
 
-	// Now we align our data to a 4-bit boundary
-	alignContainer<4>(template_main_body);
-
 	// Copy over the audio header template data and assign the correct last file index
-	std::vector<uint8_t> audio_info_data(templateDataHeader.begin(), templateDataHeader.end());
-	audio_info_data[0x11] = delta_file_count;
+	const auto audio_info = dat.subspan(layout.main_body_size, layout.audio_info_size);
+	std::ranges::copy(templateDataHeader, audio_info.begin());
+	AudioInfoHeaderLayout::write(audio_info, AudioInfoHeader{.last_index = delta_file_count});
 	// Now copy over the audio info data and assign the index for each file?
 	for(uint8_t i = 0; i < file_count; i++){
-		std::vector<uint8_t> audio_info_struct(templateDataStruct.begin(), templateDataStruct.end());
-		audio_info_struct[0x0] = i;
-		audio_info_struct[0x3] = i;
-		audio_info_data.insert(audio_info_data.end(), audio_info_struct.begin(), audio_info_struct.end());
+		const auto audio_info_struct = audio_info.subspan(templateDataHeader.size() + (i * templateDataStruct.size()), templateDataStruct.size());
+		std::ranges::copy(templateDataStruct, audio_info_struct.begin());
+		AudioInfoRecordLayout::write(audio_info_struct, AudioInfoRecord{.index = i, .index2 = i});
 	}
 
-	// Swap the endian and add the index of the last file
-	std::vector<uint8_t> file_entry_data;
-	PushBytes(file_entry_data, swap_to_big_endian<uint32_t>(delta_file_count));
-
-	// Add more magic numbers
-	std::vector<uint8_t> audio_data;
-	PushBytes(audio_data, std::string("gcaxPCMD"));
-	PushBytes(audio_data, swap_to_big_endian<uint32_t>(0x024a0100));
-	audio_data.insert(audio_data.end(), 20, '\0');
-
-	// Go to the last file in our (sorted) map and get the last ID that's specified
-	const int maxId = std::prev(Files.end())->first;
-	auto iter = Files.begin();
-	for(int i = 0; i <= maxId; i++){
-		const fs::path &wavFilePath = iter->second;
-		std::unique_ptr<std::basic_istream<char>> wavFile = std::make_unique<std::ifstream>(wavFilePath, std::ios_base::in | std::ios_base::binary);
-
-		{
-			const bool emptyFile = !Files.contains(i);
-
-			// Check and make sure this wav file is valid
-			if(emptyFile){
-				const std::scoped_lock writeLock{printLock};
-				fmt::print(warningColors,
-				           "Warning: File for ID '0x{:02X}' is empty, Replacing with empty file\n", i);
-			} else {
-				// Check and make sure we have a valid entry in the map
-				if(iter != Files.end()){
-					++iter;
-				}
-			}
-			if(emptyFile || !verifyWavFormat(printLock, wavFilePath, *dynamic_cast<std::ifstream *>(wavFile.get()))){
-				// Replace the invalid wav file with an empty one
-				const std::span<const char> emptySpan = EmptySound;
-				wavFile = std::make_unique<std::ispanstream>(emptySpan);
-				Warnings++;
-			}
+	// The file entries start with the index of the last file
+	const auto file_entry_data = dat.subspan(layout.main_body_size + layout.audio_info_size, layout.file_entry_size);
+	BigEndian::store<uint32_t>(file_entry_data, 0, delta_file_count);
+
+	// Add more magic numbers, along with the aligned length of the audio data
+	const auto audio_data = dat.subspan(layout.audio_data_start_offset, layout.audio_data_size);
+	constexpr std::string_view pcmdMagic = "gcaxPCMD";
+	std::ranges::copy(pcmdMagic, audio_data.begin());
+	PcmdHeaderLayout::write(audio_data, PcmdHeader{.version = 0x024a0100, .length = static_cast<uint32_t>(layout.audio_data_size)});
+
+	// The layout has already checked every file, so invalid ones are known to be replaced
+	for(size_t i = 0; i < layout.entries.size(); i++){
+		const auto &entry = layout.entries[i];
+		std::unique_ptr<std::basic_istream<char>> wavFile;
+		if(entry.substituted){
+			const std::span<const char> emptySpan = EmptySound;
+			wavFile = std::make_unique<std::ispanstream>(emptySpan);
+		}else{
+			wavFile = std::make_unique<std::ifstream>(Files.at(static_cast<uint8_t>(i)), std::ios_base::in | std::ios_base::binary);
 		}
 
-		uint32_t sample_rate = 0;
-		uint32_t data_length = 0;
-
-		wavFile->seekg(0x18);
-
-		wavFile->read(reinterpret_cast<char *>(&sample_rate), sizeof(sample_rate)); // NOLINT(*-pro-type-reinterpret-cast)
-		if(sample_rate != 44100){
-			const std::scoped_lock writeLock{printLock};
-			fmt::print(warningColors,
-			           "Warning: File for ID '0x{:02X}' has a sample rate of {}. "
-			           "Game will play this sound at 44100 Hz leading to pitch issues\n",
-			           i, sample_rate);
-			Warnings++;
+		// PCM data follows the data length
+		wavFile->seekg(0x2C);
+
+		std::vector<int16_t> inWav; inWav.resize(entry.data_length);
+		wavFile->read(reinterpret_cast<char *>(inWav.data()), entry.data_length); // NOLINT(*-pro-type-reinterpret-cast)
+
+		// Only the part of the samples that survived trimming gets encoded
+		const uint32_t sample_count = entry.sample_count;
+		const uint32_t adpcm_byte_count = entry.adpcm_byte_count;
+		const auto samples = std::span(inWav).subspan(entry.first_sample, sample_count);
+
+		// Encode our wav data into ADPCM, straight into its place in the audio data
+		const auto adpcm = audio_data.subspan(entry.offset, adpcm_byte_count);
+		std::array<int16_t, 16> coefficients{};
+		if(Tier == Quality::Preview){
+			encodeAdpcmPreview(samples, adpcm, coefficients);
+		}else{
+			ADPCMINFO info;
+			encode(samples.data(), adpcm.data(), &info, sample_count);
+			std::ranges::copy(info.coef, coefficients.begin());
 		}
-		wavFile->seekg(0x28);
-		wavFile->read(reinterpret_cast<char *>(&data_length), sizeof(data_length)); // NOLINT(*-pro-type-reinterpret-cast)
-
-		std::vector<int16_t> inWav; inWav.resize(data_length);
-		wavFile->read(reinterpret_cast<char *>(inWav.data()), data_length); // NOLINT(*-pro-type-reinterpret-cast)
-
-		// Samples are stored as signed 16-bit, so the sample count is half of the available data
-		const uint32_t sample_count = data_length / 2;
-		const uint32_t adpcm_byte_count = getBytesForAdpcmBuffer(sample_count);
-
-		std::vector<uint8_t> outPCM; outPCM.resize(adpcm_byte_count);
-		ADPCMINFO info;
-
-		// Encode our wav data into ADPCM
-		encode(inWav.data(), outPCM.data(), &info, sample_count);
 
 		FileEntry fileEntry{
-				.start_offset = swap_to_big_endian<uint32_t>(audio_data.size()),
-				.unk = swap_to_big_endian(2),
-				.shifted_size = swap_to_big_endian((adpcm_byte_count << 1) - 1),
-				.coefficient{},
+				.start_offset = static_cast<uint32_t>(entry.offset),
+				.unk = 2,
+				.shifted_size = (adpcm_byte_count << 1) - 1,
+				.coefficient = coefficients,
 				.unk2 = {0, 0, 0},
-				.unk3 = swap_to_big_endian(0x200),
-				.sample_rate = swap_to_big_endian<uint16_t>(sample_rate),
-				.data_size = swap_to_big_endian(adpcm_byte_count)
+				.unk3 = 0x200,
+				.sample_rate = static_cast<uint16_t>(entry.sample_rate),
+				.data_size = adpcm_byte_count
 		};
 
-		// There's no way to copy an array during initialization, so we have to do it here
-		for(size_t index = 0; index < 16; index++){
-			fileEntry.coefficient[index] = swap_to_big_endian(info.coef[index]); // NOLINT(*-pro-bounds-constant-array-index)
-		}
-
 		// Add our file entry header data
-		PushBytes(file_entry_data, fileEntry);
-
-		// now the audio data itself
-		audio_data.insert(audio_data.end(), outPCM.begin(), outPCM.end());
-
-		// Now we align to an 8-bit boundary
-		alignContainer<8>(audio_data);
-
-		// Now continue looping
+		FileEntryLayout::write(file_entry_data.subspan(sizeof(uint32_t) + (i * FileEntryLayout::size)), fileEntry);
 	}
 
-	// This time we align to a 32-bit boundary
-	const size_t aligned_length = align<32>(audio_data.size());
-	audio_data.resize(aligned_length);
-
-	// Go back and fix the length, also swaps the endian
-	replaceIntBytearray(audio_data, 0xC, aligned_length);
-
-	// Get the end of our headers and align that to a 32-bit boundary
-	const size_t end_of_info = align<32>(template_main_body.size() + audio_info_data.size() + file_entry_data.size());
-
-	const size_t eoi_msb = findMsbPosition(end_of_info);
-
-	const size_t audio_data_start_offset = 1 << (eoi_msb + 1);
-
-	// align the size of the full file to 256-bits
-	const size_t full_file_length = align<256>(audio_data_start_offset + audio_data.size());
-
-	// Now we go back and fix a couple of things
-	replaceIntBytearray(template_main_body, 0xC, full_file_length);
-
 	// Making sure we save this info for later when we use this archive
-	spec1 = end_of_info + 0x20;
-	spec2 = audio_data.size() + 0x20;
-	replaceIntBytearray(template_main_body, 0x10, spec1);
-	replaceIntBytearray(template_main_body, 0x18, spec2);
-
-	replaceIntBytearray(template_main_body, 0x1C, audio_data_start_offset);
-	replaceIntBytearray(template_main_body, 0xA8, template_main_body.size());
-	replaceIntBytearray(template_main_body, 0xB8, template_main_body.size() + audio_info_data.size());
-	replaceIntBytearray(template_main_body, 0xBC, end_of_info);
-
-	// Since we have an idea what the size should be, go ahead and reserve it
-	Dat.reserve(full_file_length);
+	spec1 = layout.end_of_info + 0x20;
+	spec2 = layout.audio_data_size + 0x20;
 
-	Dat.insert(Dat.end(), template_main_body.begin(), template_main_body.end());
-	Dat.insert(Dat.end(), audio_info_data.begin(), audio_info_data.end());
-	Dat.insert(Dat.end(), file_entry_data.begin(), file_entry_data.end());
-
-	// Align to the start offset
-	Dat.resize(audio_data_start_offset);
-	Dat.insert(Dat.end(), audio_data.begin(), audio_data.end());
-
-	// Align to the final length
-	Dat.resize(full_file_length);
+	// Now we go back and fix a couple of things
+	DtpkHeaderLayout::write(dat, DtpkHeader{
+			.full_file_length = static_cast<uint32_t>(layout.full_file_length),
+			.spec1 = spec1,
+			.spec2 = spec2,
+			.audio_data_start_offset = static_cast<uint32_t>(layout.audio_data_start_offset),
+			.audio_info_offset = static_cast<uint32_t>(layout.main_body_size),
+			.file_entry_offset = static_cast<uint32_t>(layout.main_body_size + layout.audio_info_size),
+			.end_of_info = static_cast<uint32_t>(layout.end_of_info)
+	});
 }
 // NOLINTEND(*-magic-numbers)
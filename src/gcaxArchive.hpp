@@ -8,49 +8,196 @@
 #include <memory>
 #include <vector>
 
+#include "bigEndian.hpp"
+#include "log.hpp"
+#include "silence.hpp"
+
 constexpr auto errorColors = fg(fmt::color::crimson) | fmt::emphasis::bold;
 constexpr auto warningColors = fg(fmt::color::yellow) | fmt::emphasis::bold;
 constexpr auto okColors = fg(fmt::color::green);
 
 namespace fs = std::filesystem;
 
-struct ConfigState;
-
 namespace DatPak {
+	struct EntryLayout{
+		uint32_t sample_rate;
+		uint32_t data_length; // Bytes of PCM data, as given by the header at 0x28
+		uint32_t first_sample; // Leading silence that was trimmed
+		uint32_t sample_count; // Samples that actually get encoded
+		uint32_t adpcm_byte_count;
+		size_t offset; // From the start of the audio data
+		bool substituted; // Replaced with EmptySound
+	};
+
+	/// Where everything in an archive goes. Only depends on the WAV headers
+	struct ArchiveLayout{
+		size_t file_count;
+		size_t main_body_size;
+		size_t audio_info_size;
+		size_t file_entry_size;
+		size_t end_of_info; // Headers aligned to 32 bytes
+		size_t audio_data_start_offset; // Next power of two after end_of_info
+		size_t audio_data_size;
+		size_t full_file_length;
+		uint_fast8_t warnings;
+		size_t trimmed_bytes; // ADPCM data saved by trimming silence
+		std::vector<EntryLayout> entries;
+
+		[[nodiscard]] size_t headerSize() const noexcept;
+
+		/// Bytes between the end of the headers and the start of the audio data
+		[[nodiscard]] size_t headerPadding() const noexcept{ return audio_data_start_offset - headerSize(); }
+
+		/// Bytes used to align each entry and the audio data as a whole
+		[[nodiscard]] size_t entryPadding() const noexcept;
+
+		[[nodiscard]] size_t tailPadding() const noexcept{ return full_file_length - audio_data_start_offset - audio_data_size; }
+
+		/// The most memory building this archive holds at once
+		[[nodiscard]] size_t estimatePeakMemory() const noexcept;
+
+		/// Works out where each entry goes in the audio data, and the size of the audio data and the file from that
+		void placeEntries() noexcept;
+	};
+
+	enum class Quality : uint8_t{
+		Preview, // Fixed predictors, only for iterating on sounds
+		Final,
+	};
+
 	class GCAXArchive{
 		uint16_t ID; // Read-only
 		fs::path FilePath; // Read-only
 		std::map<uint8_t, fs::path> Files;
 		std::vector<uint8_t> Dat;
 		uint_fast8_t Warnings;
+		Quality Tier; // Read-only
 
 		uint32_t spec1; // Todo: Give these a real name. For now, they match the DATFile struct names
 		uint32_t spec2;
 
 	public:
-		GCAXArchive(const uint16_t& datID, fs::path&& filePath, std::map<uint8_t, fs::path>&& files, std::mutex& printLock);
+		GCAXArchive(const uint16_t& datID, fs::path&& filePath, std::map<uint8_t, fs::path>&& files, const ArchiveLayout& layout, Quality quality);
+
+		/** Works out the layout of the archive these files would build, reading only the WAV headers.
+		 *  Missing or invalid files are reported here and replaced with an empty sound.
+		 */
+		[[nodiscard]] static ArchiveLayout plan(const fs::path& filePath, const std::map<uint8_t, fs::path>& files, LogBuffer& report);
+
+		/** Reads the samples of every entry, one at a time, and shrinks the layout to their audible parts.
+		 *  Trimming only ever makes the archive smaller, so a reservation for the planned layout still covers it.
+		 */
+		static void trimSilence(ArchiveLayout& layout, const std::map<uint8_t, fs::path>& files, const SilenceOptions& options, LogBuffer& report);
 
 		[[nodiscard]] const uint_fast8_t& getWarningCount() const;
 
+		[[nodiscard]] Quality getQuality() const noexcept{ return Tier; }
+
+		[[nodiscard]] std::span<const uint8_t> getData() const noexcept{ return Dat; }
+
 		void incrementWarning();
 
-		void WriteFile(const fs::path& config) const;
+		/// Returns false if the archive couldn't be written out in full
+		[[nodiscard]] bool WriteFile(const fs::path& config, LogBuffer& report) const;
+
+		/** Decodes every entry using its stored coefficients and compares it against the source audio.
+		 *  Fails if an entry was replaced, doesn't match its source's length, or falls below minimumSnr.
+		 */
+		[[nodiscard]] bool verify(const ArchiveLayout& layout, double minimumSnr, LogBuffer& report) const;
+
+		[[maybe_unused]] void CompareFile(LogBuffer& report, const fs::path& file) const;
+	};
+
+	// NOLINTBEGIN(*-magic-numbers)
+	/// Patched into the gcaxDTPK header at the start of the main body
+	struct DtpkHeader{
+		uint32_t full_file_length;
+		uint32_t spec1; // Todo: Give these a real name. For now, they match the DATFile struct names
+		uint32_t spec2;
+		uint32_t audio_data_start_offset;
+		uint32_t audio_info_offset;
+		uint32_t file_entry_offset;
+		uint32_t end_of_info;
+	};
+	using DtpkHeaderLayout = BigEndian::RecordLayout<0xC0,
+			BigEndian::Field<&DtpkHeader::full_file_length, 0x0C>,
+			BigEndian::Field<&DtpkHeader::spec1, 0x10>,
+			BigEndian::Field<&DtpkHeader::spec2, 0x18>,
+			BigEndian::Field<&DtpkHeader::audio_data_start_offset, 0x1C>,
+			BigEndian::Field<&DtpkHeader::audio_info_offset, 0xA8>,
+			BigEndian::Field<&DtpkHeader::file_entry_offset, 0xB8>,
+			BigEndian::Field<&DtpkHeader::end_of_info, 0xBC>>;
+
+	/// Follows the main body template, before the sound table
+	struct SoundTableHeader{
+		uint16_t id;
+		uint16_t unk;
+		uint8_t last_index;
+	};
+	using SoundTableHeaderLayout = BigEndian::RecordLayout<8,
+			BigEndian::Field<&SoundTableHeader::id, 0x0>,
+			BigEndian::Field<&SoundTableHeader::unk, 0x2>,
+			BigEndian::Field<&SoundTableHeader::last_index, 0x4>>;
+
+	struct SoundTableRecord{
+		uint16_t unk;
+		uint8_t index;
+		uint16_t unk2;
+		uint8_t unk3;
+	};
+	using SoundTableRecordLayout = BigEndian::RecordLayout<6,
+			BigEndian::Field<&SoundTableRecord::unk, 0x0>,
+			BigEndian::Field<&SoundTableRecord::index, 0x2>,
+			BigEndian::Field<&SoundTableRecord::unk2, 0x3>,
+			BigEndian::Field<&SoundTableRecord::unk3, 0x5>>;
+
+	/// Patched into templateDataHeader
+	struct AudioInfoHeader{
+		uint8_t last_index;
+	};
+	using AudioInfoHeaderLayout = BigEndian::RecordLayout<0x30,
+			BigEndian::Field<&AudioInfoHeader::last_index, 0x11>>;
 
-		[[maybe_unused]] void CompareFile(std::mutex& printLock, const fs::path& file) const;
+	/// Patched into each copy of templateDataStruct
+	struct AudioInfoRecord{
+		uint8_t index;
+		uint8_t index2;
 	};
+	using AudioInfoRecordLayout = BigEndian::RecordLayout<0x40,
+			BigEndian::Field<&AudioInfoRecord::index, 0x0>,
+			BigEndian::Field<&AudioInfoRecord::index2, 0x3>>;
 
 	struct FileEntry{
-		[[maybe_unused]] uint32_t start_offset;
-		[[maybe_unused]] int32_t unk;
-		[[maybe_unused]] uint32_t shifted_size;
-		std::array<int16_t, 16> coefficient; // NOLINT(*-magic-numbers)
+		uint32_t start_offset;
+		int32_t unk;
+		uint32_t shifted_size;
+		std::array<int16_t, 16> coefficient;
 		std::array<int32_t, 3> unk2;
-		[[maybe_unused]] int32_t unk3;
-		[[maybe_unused]] uint16_t sample_rate;
-		[[maybe_unused]] uint32_t data_size;
+		int32_t unk3;
+		uint16_t sample_rate;
+		uint32_t data_size;
+	};
+	using FileEntryLayout = BigEndian::RecordLayout<0x44,
+			BigEndian::Field<&FileEntry::start_offset, 0x00>,
+			BigEndian::Field<&FileEntry::unk, 0x04>,
+			BigEndian::Field<&FileEntry::shifted_size, 0x08>,
+			BigEndian::Field<&FileEntry::coefficient, 0x0C>,
+			BigEndian::Field<&FileEntry::unk2, 0x2C>,
+			BigEndian::Field<&FileEntry::unk3, 0x38>,
+			BigEndian::Field<&FileEntry::sample_rate, 0x3C>,
+			BigEndian::Field<&FileEntry::data_size, 0x40>>;
+
+	/// Header of the audio data, after the gcaxPCMD magic
+	struct PcmdHeader{
+		uint32_t version;
+		uint32_t length;
 	};
+	using PcmdHeaderLayout = BigEndian::RecordLayout<0x20,
+			BigEndian::Field<&PcmdHeader::version, 0x08>,
+			BigEndian::Field<&PcmdHeader::length, 0x0C>>;
+	// NOLINTEND(*-magic-numbers)
 
-	bool verifyWavFormat(std::mutex& printLock, const fs::path& wavFilePath, std::ifstream& wavFile);
+	bool verifyWavFormat(LogBuffer& report, const fs::path& wavFilePath, std::ifstream& wavFile);
 
 	/** Check if a number is a power of 2 or not.
 	 *  IF n is power of 2, return true, else return false.
@@ -71,74 +218,5 @@ namespace DatPak {
 		return (num + shift) & ~shift;
 	}
 
-	template<class T>
-	concept ResizableArray = requires(T container){
-		container.size();
-		container.resize(std::size_t{0});
-	};
-
-	template<int alignTo, typename T>
-		requires ResizableArray<T>
-	void alignContainer(T& container){
-		size_t aligned = align<alignTo>(container.size());
-		container.resize(aligned);
-	}
-
 	constexpr size_t findMsbPosition(size_t n){ return static_cast<std::size_t>(gcem::log2(n)); }
-
-	template<typename T, size_t size = sizeof(T)>
-	union TypeToBytes{
-		T u;
-		std::array<uint8_t, size> u8;
-	};
-
-	template<typename T>
-	void replaceIntBytearray(T& arr, const size_t& offset, const uint32_t& n){
-		// NOLINTBEGIN
-		TypeToBytes nb{.u = n};
-		if constexpr (std::endian::native == std::endian::little) {
-			arr[offset] = nb.u8[3];
-			arr[offset + 1] = nb.u8[2];
-			arr[offset + 2] = nb.u8[1];
-			arr[offset + 3] = nb.u8[0];
-		} else {
-			arr[offset] = nb.u8[0];
-			arr[offset + 1] = nb.u8[1];
-			arr[offset + 2] = nb.u8[2];
-			arr[offset + 3] = nb.u8[3];
-		}
-		// NOLINTEND
-	}
-
-	template<typename T, size_t size = sizeof(T)>
-	constexpr T swap_to_big_endian(const T& data){
-		static_assert(CHAR_BIT == 8, "CHAR_BIT != 8"); // NOLINT(*-magic-numbers)
-		if constexpr (size == 1) {
-			return data;
-		}
-		if constexpr (std::endian::native == std::endian::little) { // NOLINT
-			TypeToBytes<T> source;
-			TypeToBytes<T> dest;
-
-			source.u = data;
-
-			for (size_t i = 0; i < size; i++) {
-				dest.u8[i] = source.u8[size - i - 1];
-			}
-
-			return dest.u;
-		} else {
-			return data;
-		}
-	}
-
-	template<typename T>
-	void PushBytes(std::vector<uint8_t>& vector, const T& val){
-		TypeToBytes<T> valBytes{.u = val};
-
-		vector.insert(vector.end(), valBytes.u8.begin(), valBytes.u8.end());
-	}
-
-	template<>
-	void PushBytes<std::string>(std::vector<uint8_t>& vector, const std::string& val);
 } // namespace DatPak
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <charconv>
+#include <numeric>
+#include <stdexcept>
+
+#include "gcaxArchive.hpp"
+#include "jobGraph.hpp"
+
+namespace {
+	fs::path normalise(const fs::path &path){
+		std::error_code errorCode;
+		auto canonical = fs::weakly_canonical(path, errorCode);
+		if(errorCode){
+			return fs::absolute(path).lexically_normal();
+		}
+		return canonical;
+	}
+} // namespace
+
+DatPak::JobGraph::AddResult DatPak::JobGraph::add(BuildJob &&job, LogBuffer &report){
+	job.BankConfig = normalise(job.BankConfig);
+	job.Output = normalise(job.Output);
+
+	const auto existing = ByOutput.find(job.Output);
+	if(existing == ByOutput.end()){
+		ByOutput.emplace(job.Output, Jobs.size());
+		Jobs.emplace_back(std::move(job));
+		return AddResult::Added;
+	}
+
+	const auto &other = Jobs[existing->second];
+	if(other.BankConfig == job.BankConfig && other.ID == job.ID){
+		report.print(Severity::Debug, "{} is also listed in {}, building it once\n",
+		             job.Output.string(), job.MainConfig.string());
+		return AddResult::Merged;
+	}
+
+	report.print(Severity::Error, errorColors,
+	             "Conflicting jobs for {}:\n\t{} (0x{:X}) from {}\n\t{} (0x{:X}) from {}\n\tKeeping the first one\n",
+	             job.Output.string(),
+	             other.BankConfig.string(), other.ID, other.MainConfig.string(),
+	             job.BankConfig.string(), job.ID, job.MainConfig.string());
+	return AddResult::Conflict;
+}
+
+DatPak::Shard DatPak::parseShard(const std::string_view shard){
+	const auto slash = shard.find('/');
+	Shard result{.index = 0, .count = 0};
+	if(slash != std::string_view::npos){
+		const auto index = shard.substr(0, slash);
+		const auto count = shard.substr(slash + 1);
+		const auto [indexEnd, indexError] = std::from_chars(index.data(), index.data() + index.size(), result.index);
+		const auto [countEnd, countError] = std::from_chars(count.data(), count.data() + count.size(), result.count);
+		if(indexError != std::errc{} || countError != std::errc{} || indexEnd != index.data() + index.size() || countEnd != count.data() + count.size()){
+			result = {.index = 0, .count = 0};
+		}
+	}
+	if(result.index == 0 || result.index > result.count){
+		throw std::invalid_argument(fmt::format("Invalid shard \"{}\", expected i/n with 1 <= i <= n", shard));
+	}
+	return result;
+}
+
+std::string DatPak::outputKey(const fs::path &output, const fs::path &outputRoot){
+	return output.lexically_relative(normalise(outputRoot)).generic_string();
+}
+
+void DatPak::JobGraph::keepShard(const Shard &shard, const std::span<const uint64_t> weights, const fs::path &outputRoot){
+	std::vector<std::string> keys;
+	keys.reserve(Jobs.size());
+	for(const auto &job: Jobs){
+		keys.emplace_back(outputKey(job.Output, outputRoot));
+	}
+
+	std::vector<size_t> order(Jobs.size());
+	std::iota(order.begin(), order.end(), size_t{0});
+	std::ranges::sort(order, [&](const size_t lhs, const size_t rhs) noexcept{
+		if(weights[lhs] != weights[rhs]){
+			return weights[lhs] > weights[rhs];
+		}
+		return keys[lhs] < keys[rhs];
+	});
+
+	// Each job goes to the lightest shard so far, the first one if several are tied
+	std::vector<uint64_t> load(shard.count);
+	std::vector<bool> keep(Jobs.size());
+	for(const size_t job: order){
+		const auto lightest = std::ranges::min_element(load);
+		*lightest += weights[job] + 1; // Jobs without any audio still cost something
+		keep[job] = static_cast<size_t>(lightest - load.begin()) == shard.index - 1;
+	}
+
+	std::vector<BuildJob> kept;
+	ByOutput.clear();
+	for(size_t i = 0; i < Jobs.size(); i++){
+		if(keep[i]){
+			ByOutput.emplace(Jobs[i].Output, kept.size());
+			kept.emplace_back(std::move(Jobs[i]));
+		}
+	}
+	Jobs = std::move(kept);
+}
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "log.hpp"
+
+namespace fs = std::filesystem;
+
+namespace DatPak {
+	/// One archive to build, as listed in a main config file
+	struct BuildJob{
+		fs::path BankConfig;
+		uint16_t ID;
+		fs::path Output;
+		fs::path MainConfig; // The config that first listed this job
+	};
+
+	/// Which slice of the jobs this process builds, counted from 1 as in "--shard 2/4"
+	struct Shard{
+		uint32_t index;
+		uint32_t count;
+	};
+
+	Shard parseShard(std::string_view shard);
+
+	/// The output path relative to the output directory, which is the same on every machine
+	std::string outputKey(const fs::path &output, const fs::path &outputRoot);
+
+	/** Every archive requested by every config, built before any work starts.
+	 *  Jobs that are listed more than once are only kept once, and jobs that would write
+	 *  different archives to the same output are rejected.
+	 */
+	class JobGraph{
+		std::vector<BuildJob> Jobs;
+		std::map<fs::path, size_t> ByOutput;
+
+	public:
+		enum class AddResult : uint8_t{
+			Added,
+			Merged,
+			Conflict,
+		};
+
+		AddResult add(BuildJob &&job, LogBuffer &report);
+
+		/** Drops every job that isn't in the given shard. Jobs are spread over the shards by weight, heaviest first,
+		 *  with ties broken by outputKey. Every worker given the same configs and weights makes the same split.
+		 */
+		void keepShard(const Shard &shard, std::span<const uint64_t> weights, const fs::path &outputRoot);
+
+		[[nodiscard]] const std::vector<BuildJob> &jobs() const noexcept{ return Jobs; }
+	};
+} // namespace DatPak
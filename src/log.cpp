@@ -0,0 +1,69 @@
+#include <cstdio>
+
+#include "log.hpp"
+
+DatPak::LogSink DatPak::logSink; // NOLINT(*-avoid-non-const-global-variables)
+
+void DatPak::LogSink::start(){
+	const std::scoped_lock lock{Lock};
+	if(!Worker.joinable()){
+		Worker = std::jthread([this](const std::stop_token &stopToken){ run(stopToken); });
+	}
+}
+
+void DatPak::LogSink::stop(){
+	std::jthread worker;
+	{
+		const std::scoped_lock lock{Lock};
+		worker = std::move(Worker);
+	}
+	if(worker.joinable()){
+		// The worker wakes up from its own stop token
+		worker.request_stop();
+		worker.join();
+	}
+}
+
+void DatPak::LogSink::submit(std::string &&block){
+	if(block.empty()){
+		return;
+	}
+	bool queued = false;
+	{
+		const std::scoped_lock lock{Lock};
+		if(Worker.joinable()){
+			Queue.emplace_back(std::move(block));
+			queued = true;
+		}
+	}
+	if(queued){
+		Pending.notify_one();
+		return;
+	}
+	// No worker running, so nothing else can be writing right now
+	std::fwrite(block.data(), 1, block.size(), stdout);
+	std::fflush(stdout);
+}
+
+void DatPak::LogSink::run(const std::stop_token &stopToken){
+	std::vector<std::string> blocks;
+	while(true){
+		{
+			std::unique_lock lock{Lock};
+			Pending.wait(lock, stopToken, [&]{ return !Queue.empty(); });
+			if(Queue.empty()){
+				break; // Only reached once stopping and everything has been written
+			}
+			blocks.swap(Queue);
+		}
+		for(const auto &block: blocks){
+			std::fwrite(block.data(), 1, block.size(), stdout);
+		}
+		std::fflush(stdout);
+		blocks.clear();
+	}
+}
+
+void DatPak::LogBuffer::flush(){
+	logSink.submit(std::exchange(Buffer, {}));
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <iterator>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <fmt/color.h>
+#include <fmt/core.h>
+
+namespace DatPak {
+	enum class Severity : uint8_t{
+		Error,
+		Warning,
+		Report, // Output that was asked for, such as --plan
+		Info, // Shown with -v
+		Debug, // Shown with -vv
+	};
+
+	/** Owns stdout. Finished blocks of text are queued by any thread and written out by a single worker,
+	 *  so a block is never interleaved with another one.
+	 */
+	class LogSink{
+		std::atomic<size_t> Verbosity = 0;
+
+		std::mutex Lock;
+		std::condition_variable_any Pending; // Waits on the worker's stop token too, so a stop can't slip in before it blocks
+		std::vector<std::string> Queue;
+		std::jthread Worker;
+
+		void run(const std::stop_token &stopToken);
+
+	public:
+		void setVerbosity(size_t verbosity) noexcept{ Verbosity = verbosity; }
+
+		[[nodiscard]] bool enabled(const Severity severity) const noexcept{
+			switch(severity){
+				case Severity::Info: return Verbosity >= 1;
+				case Severity::Debug: return Verbosity >= 2;
+				case Severity::Error:
+				case Severity::Warning:
+				case Severity::Report:
+				default: return true;
+			}
+		}
+
+		/// Starts the worker thread. Until then, blocks are written straight away on the calling thread
+		void start();
+
+		/// Writes out everything that was queued and stops the worker thread
+		void stop();
+
+		void submit(std::string &&block);
+	};
+
+	extern LogSink logSink; // NOLINT(*-avoid-non-const-global-variables)
+
+	/** Collects the messages for one unit of work (an archive, a config, ...) so they are written as one block.
+	 *  Messages below the current verbosity are dropped before they're formatted.
+	 */
+	class LogBuffer{
+		std::string Buffer;
+
+	public:
+		LogBuffer() = default;
+		LogBuffer(const LogBuffer &) = delete;
+		LogBuffer &operator=(const LogBuffer &) = delete;
+		LogBuffer(LogBuffer &&) = default;
+		LogBuffer &operator=(LogBuffer &&) = default;
+		~LogBuffer(){ flush(); }
+
+		template<typename... Args>
+		void print(const Severity severity, fmt::format_string<Args...> format, Args &&...args){
+			if(!logSink.enabled(severity)){
+				return;
+			}
+			fmt::format_to(std::back_inserter(Buffer), format, std::forward<Args>(args)...);
+		}
+
+		template<typename... Args>
+		void print(const Severity severity, const fmt::text_style &style, fmt::format_string<Args...> format, Args &&...args){
+			if(!logSink.enabled(severity)){
+				return;
+			}
+			fmt::vformat_to(std::back_inserter(Buffer), style, static_cast<fmt::string_view>(format), fmt::make_format_args(args...));
+		}
+
+		/// Hands everything collected so far to the sink as a single block
+		void flush();
+
+		/// Drops everything collected so far without writing it
+		void clear() noexcept{ Buffer.clear(); }
+	};
+} // namespace DatPak
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <list>
 #include <map>
+#include <string_view>
 #include <thread>
 #include <fmt/color.h>
 #include <fmt/core.h>
@@ -31,11 +32,14 @@ int main(const int argc, const char *argv[]){
 }
 
 return_code processInput(const std::span<const char*> args) noexcept{ // NOLINT(*-function-cognitive-complexity)
-	auto &[result, printLock] = programState;
-	std::atomic<uint_fast8_t> errors = 0;
-	std::atomic<uint_fast8_t> warnings = 0;
-	std::atomic<uint_fast8_t> generated = 0;
-	std::atomic<uint_fast8_t> skipped = 0;
+	if(args.size() > 1 && std::string_view(args[1]) == "merge-report"){
+		return processMergeReport(args.subspan(1));
+	}
+
+	auto &[result, memoryBudget] = programState;
+	DatPak::LogBuffer summary;
+	BuildState state;
+	auto &[configErrors, errors, warnings, generated, skipped, failedVerification, previews] = state;
 	try{
 		cxxopts::Options options("DatPak", "Creates GCAX sound archives to be used by Sonic Riders");
 		options.add_options()
@@ -43,93 +47,245 @@ return_code processInput(const std::span<const char*> args) noexcept{ // NOLINT(
 						("v,verbose", "Verbose output.") // Implicitly bool
 						("f,force", "Force generation.")
 						("c,config", "Config File path.", cxxopts::value<std::vector<fs::path>>())
-						("o,output", "Directory to write to.", cxxopts::value<fs::path>()->default_value("Output/"));
+						("o,output", "Directory to write to.", cxxopts::value<fs::path>()->default_value("Output/"))
+						("plan", "Only read the WAV headers and print the layout and size of every archive.")
+						("quality", "Encoder quality, preview or final. Preview is much faster but only meant for iterating on sounds.", cxxopts::value<std::string>()->default_value("final"))
+						("trim-silence", "Trim leading and trailing silence from every sound before encoding it.")
+						("silence-floor", "Samples at or below this amplitude count as silence for --trim-silence.", cxxopts::value<uint16_t>()->default_value("16"))
+						("silence-margin", "Milliseconds of silence --trim-silence keeps on either side.", cxxopts::value<uint32_t>()->default_value("10"))
+						("verify", "Decode every archive after it's built and compare it against the source audio.")
+						("verify-snr", "Minimum SNR in dB an entry needs to pass --verify.", cxxopts::value<double>()->default_value("20"))
+						("max-memory", "Limit the estimated memory used by archives being built at once, e.g. 4G. Unlimited by default.", cxxopts::value<std::string>())
+						("shard", "Only build slice i of n, e.g. 2/4. Every worker given the same configs splits the archives the same way.", cxxopts::value<std::string>())
+						("report", "Write what was built to this file, to be combined with \"DatPak merge-report\".", cxxopts::value<fs::path>());
 		options.parse_positional({"config"});
 		result = options.parse(static_cast<int>(args.size()), args.data());
+		DatPak::logSink.setVerbosity(programState.verbose());
 		if(result.count("help") != 0 || result.count("config") == 0) {
-			const std::scoped_lock writeLock{printLock};
-			fmt::print("{}", options.help());
+			DatPak::logSink.submit(options.help());
 			return return_code::HelpShown;
 		}
 
+		DatPak::logSink.start();
+
+		memoryBudget.setLimit(programState.maxMemory());
+		const auto quality = programState.quality(); // Checked before any work starts
+
 		// ReSharper disable once CppLocalVariableMayBeConst
 		std::vector<fs::path> configs = programState.config();
 		const fs::path &output = programState.output();
 
 		fs::create_directory(output); // Create output directory if it doesn't exist
 
-		std::vector<std::jthread> threads;
-
+		// Collect the jobs from every config first, so each archive is only built once per run
+		DatPak::JobGraph jobs;
 		for(auto &config : configs){
-			threads.emplace_back([&]{
-				ConfigState configState;
-				fs::path configParent;
-				if(fs::is_directory(config)){
-					configParent = config;
-					config.append("config.txt");
-				}else{
-					configParent = config.parent_path();
-				}
-
-				if(programState.verbose() > 0){
-					const std::scoped_lock writeLock{printLock};
-					fmt::print("Loaded config {}, outputting to {}\n", config.string(), output.string());
-				}
-
-				processMainConfigFile(configState, config, configParent);
-
-				for(const auto &archive: configState.archives){
-					archive.WriteFile(config);
-					if(archive.getWarningCount() != 0U){
-						++configState.warnings;
-						--configState.generated;
-					}
-				}
-				errors += configState.errors;
-				warnings += configState.warnings;
-				generated += configState.generated;
-				skipped += configState.skipped;
-			});
+			fs::path configParent;
+			if(fs::is_directory(config)){
+				configParent = config;
+				config.append("config.txt");
+			}else{
+				configParent = config.parent_path();
+			}
+
+			summary.print(DatPak::Severity::Info, "Loaded config {}, outputting to {}\n", config.string(), output.string());
+			summary.flush();
+
+			processMainConfigFile(state, jobs, config, configParent);
+		}
+
+		const auto shard = programState.shard();
+		if(shard.has_value()){
+			std::vector<uint64_t> weights;
+			weights.reserve(jobs.jobs().size());
+			for(const auto &job : jobs.jobs()){
+				weights.emplace_back(shardWeight(job));
+			}
+			const size_t jobCount = jobs.jobs().size();
+			jobs.keepShard(*shard, weights, output);
+			summary.print(DatPak::Severity::Info, "Building shard {}/{}: {} of {} archives\n", shard->index, shard->count, jobs.jobs().size(), jobCount);
+			summary.flush();
+		}
+
+		if(result.count("plan") != 0){
+			size_t total = 0;
+			for(const auto &job : jobs.jobs()){
+				total += planVoiceFiles(state, job);
+			}
+			DatPak::logSink.stop();
+			summary.print(DatPak::Severity::Report, "\nPlanned {} archives, {} bytes in total\n", jobs.jobs().size(), total);
+			if(warnings != 0U){
+				summary.print(DatPak::Severity::Warning, warningColors, "{} archives would be generated with issues\n", warnings.load());
+			}
+			if(configErrors != 0U){
+				summary.print(DatPak::Severity::Error, errorColors, "Found {} problems in the configs\n", configErrors.load());
+			}
+			if(errors != 0U){
+				summary.print(DatPak::Severity::Error, errorColors, "Failed to plan {} archives\n", errors.load());
+			}
+			if(errors != 0U || configErrors != 0U){
+				// Don't let a CI gate mistake a plan with missing archives for one that fits
+				return return_code::PlanFailed;
+			}
+			return return_code::Ok;
+		}
+
+		std::vector<DatPak::ArchiveRecord> records(jobs.jobs().size());
+		{
+			std::vector<std::jthread> threads;
+			threads.reserve(jobs.jobs().size());
+			for(size_t i = 0; i < jobs.jobs().size(); i++){
+				threads.emplace_back(processVoiceFiles, std::ref(state), std::cref(jobs.jobs()[i]), quality, std::ref(records[i]));
+			}
+			// threads destructor calls jthread destructor which joins so no manual joining needed
+		}
+
+		if(const auto reportPath = programState.report()){
+			const DatPak::BuildReport buildReport{
+					.Slice = shard.value_or(DatPak::Shard{.index = 1, .count = 1}),
+					.ConfigErrors = configErrors.load(),
+					.Errors = errors.load(),
+					.Warnings = warnings.load(),
+					.Generated = generated.load(),
+					.Skipped = skipped.load(),
+					.FailedVerification = failedVerification.load(),
+					.Previews = previews.load(),
+					.Archives = std::move(records)
+			};
+			std::ofstream reportFile(*reportPath);
+			reportFile.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+			buildReport.write(reportFile);
 		}
 	}catch(cxxopts::exceptions::exception &err){
-		const std::scoped_lock writeLock{printLock};
-		fmt::print(errorColors, "{}\n", err.what());
+		summary.print(DatPak::Severity::Error, errorColors, "{}\n", err.what());
+		DatPak::logSink.stop();
 		return return_code::CxxoptException;
 	}catch(fs::filesystem_error &err){
-		const std::scoped_lock writeLock{printLock};
-		fmt::print(errorColors, "{}\n", err.what());
+		summary.print(DatPak::Severity::Error, errorColors, "{}\n", err.what());
+		DatPak::logSink.stop();
 		return return_code::FilesystemException;
 	}catch(std::exception &err){
-		const std::scoped_lock writeLock{printLock};
-		fmt::print(errorColors, "{}\n", err.what());
+		summary.print(DatPak::Severity::Error, errorColors, "{}\n", err.what());
+		DatPak::logSink.stop();
 		return return_code::GeneralException;
 	}
-	const std::scoped_lock writeLock{printLock};
+	// Everything else has been queued by now, so the summary always comes last
+	DatPak::logSink.stop();
+	if(configErrors != 0U){
+		summary.print(DatPak::Severity::Error, errorColors, "\nFound {} problems in the configs\n", configErrors.load());
+	}
 	if(errors != 0U){
-		fmt::print(errorColors, "\nFailed to generate {} files\n", errors.load());
+		summary.print(DatPak::Severity::Error, errorColors, "\nFailed to generate {} files\n", errors.load());
 	}
 	if(warnings != 0U){
-		fmt::print(warningColors, "\nGenerated {} files with issues\n", warnings.load());
+		summary.print(DatPak::Severity::Warning, warningColors, "\nGenerated {} files with issues\n", warnings.load());
+	}
+	if(failedVerification != 0U){
+		summary.print(DatPak::Severity::Error, errorColors, "\n{} files failed verification\n", failedVerification.load());
+	}
+	if(previews != 0U){
+		summary.print(DatPak::Severity::Warning, warningColors, "{} files were built with preview quality and must not be released\n", previews.load());
+	}
+	if(skipped != 0U){
+		summary.print(DatPak::Severity::Info, okColors, "{} files were unmodified\n", skipped.load());
+	}
+	if(generated != 0U){
+		summary.print(DatPak::Severity::Info, okColors, "Successfully generated {} files\n", generated.load());
 	}
-	if(programState.verbose() > 0){
-		if(skipped != 0U){
-			fmt::print(okColors, "{} files were unmodified\n", skipped.load());
+	const auto highWater = DatPak::formatByteSize(memoryBudget.getHighWater());
+	if(memoryBudget.getLimit() != 0U){
+		summary.print(DatPak::Severity::Report, "Peak estimated memory in flight: {} of {}\n", highWater, DatPak::formatByteSize(memoryBudget.getLimit()));
+	}else{
+		summary.print(DatPak::Severity::Info, "Peak estimated memory in flight: {}\n", highWater);
+	}
+	if(failedVerification != 0U){
+		return return_code::VerificationFailed;
+	}
+	return return_code::Ok;
+}
+
+return_code processMergeReport(const std::span<const char*> args) noexcept{
+	auto &result = programState.result;
+	DatPak::LogBuffer summary;
+	try{
+		cxxopts::Options options("DatPak merge-report", "Combines the --report files from every shard of a build");
+		options.add_options()
+						("h,help", "Show help.")
+						("v,verbose", "Verbose output.")
+						("o,output", "Write the merged report to this file.", cxxopts::value<fs::path>())
+						("reports", "Report files to merge.", cxxopts::value<std::vector<fs::path>>());
+		options.parse_positional({"reports"});
+		result = options.parse(static_cast<int>(args.size()), args.data());
+		DatPak::logSink.setVerbosity(programState.verbose());
+		if(result.count("help") != 0 || result.count("reports") == 0) {
+			DatPak::logSink.submit(options.help());
+			return return_code::HelpShown;
 		}
-		if(generated != 0U){
-			fmt::print(okColors, "Successfully generated {} files\n", generated.load());
+
+		std::vector<DatPak::BuildReport> reports;
+		for(const auto &path : result["reports"].as<std::vector<fs::path>>()){
+			std::ifstream reportFile(path);
+			if(!reportFile){
+				throw std::runtime_error(fmt::format("Report {} failed to open", path.string()));
+			}
+			reports.emplace_back(DatPak::BuildReport::read(reportFile));
+		}
+
+		DatPak::BuildReport merged;
+		const bool consistent = DatPak::mergeReports(reports, merged, summary);
+		if(result.count("output") != 0){
+			std::ofstream mergedFile(result["output"].as<fs::path>());
+			mergedFile.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+			merged.write(mergedFile);
 		}
+
+		summary.print(DatPak::Severity::Report, "Merged {} reports covering {} archives\n", reports.size(), merged.Archives.size());
+		if(merged.ConfigErrors != 0U){
+			summary.print(DatPak::Severity::Error, errorColors, "Found {} problems in the configs\n", merged.ConfigErrors);
+		}
+		if(merged.Errors != 0U){
+			summary.print(DatPak::Severity::Error, errorColors, "Failed to generate {} files\n", merged.Errors);
+		}
+		if(merged.Warnings != 0U){
+			summary.print(DatPak::Severity::Warning, warningColors, "Generated {} files with issues\n", merged.Warnings);
+		}
+		if(merged.FailedVerification != 0U){
+			summary.print(DatPak::Severity::Error, errorColors, "{} files failed verification\n", merged.FailedVerification);
+		}
+		if(merged.Previews != 0U){
+			summary.print(DatPak::Severity::Warning, warningColors, "{} files were built with preview quality and must not be released\n", merged.Previews);
+		}
+		if(merged.Skipped != 0U){
+			summary.print(DatPak::Severity::Info, okColors, "{} files were unmodified\n", merged.Skipped);
+		}
+		if(merged.Generated != 0U){
+			summary.print(DatPak::Severity::Info, okColors, "Successfully generated {} files\n", merged.Generated);
+		}
+
+		if(!consistent){
+			return return_code::ReportMismatch;
+		}
+		if(merged.FailedVerification != 0U){
+			return return_code::VerificationFailed;
+		}
+	}catch(cxxopts::exceptions::exception &err){
+		summary.print(DatPak::Severity::Error, errorColors, "{}\n", err.what());
+		return return_code::CxxoptException;
+	}catch(std::exception &err){
+		summary.print(DatPak::Severity::Error, errorColors, "{}\n", err.what());
+		return return_code::GeneralException;
 	}
 	return return_code::Ok;
 }
 
-void processMainConfigFile(ConfigState &state, const fs::path &config, const fs::path &configParent){
+void processMainConfigFile(BuildState &state, DatPak::JobGraph &jobs, const fs::path &config, const fs::path &configParent){
 	std::ifstream mainConfigFile(config);
 
 	if(!mainConfigFile){
 		throw std::runtime_error("Main config file stream failed to open");
 	}
 
-	std::vector<std::jthread> threads;
+	DatPak::LogBuffer report;
 
 	while(mainConfigFile.good()){
 		auto peek = mainConfigFile.peek();
@@ -139,10 +295,7 @@ void processMainConfigFile(ConfigState &state, const fs::path &config, const fs:
 		}
 		if(peek == '#'){
 			mainConfigFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Go to the next line
-			if(programState.verbose() > 1){
-				const std::scoped_lock writeLock{programState.printLock};
-				fmt::print("Skipping comment, going to next line\n");
-			}
+			report.print(DatPak::Severity::Debug, "Skipping comment, going to next line\n");
 			continue; // Skip comments
 		}
 
@@ -181,30 +334,33 @@ void processMainConfigFile(ConfigState &state, const fs::path &config, const fs:
 
 			outputFilePath += ".DAT";
 
-			threads.emplace_back(processVoiceFiles, std::ref(state), bankDir, bankConf, datID, programState.output() / outputFilePath);
+			if(jobs.add({bankConf, datID, programState.output() / outputFilePath, config}, report) == DatPak::JobGraph::AddResult::Conflict){
+				++state.configErrors;
+			}
 		}catch(std::exception &err){
-			const std::scoped_lock writeLock{programState.printLock};
-			fmt::print(errorColors, "{}\n", err.what());
-			++state.errors;
+			report.print(DatPak::Severity::Error, errorColors, "{}\n", err.what());
+			++state.configErrors;
 		}
 
 		mainConfigFile.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Go to the next line
 	}
 
-	// threads destructor calls jthread destructor which joins so no manual joining needed
+	report.flush();
 }
 
-void processVoiceFiles(ConfigState &state, const fs::path &parent, const fs::path &configFile, const uint16_t &datID, fs::path filePath){
+BankFiles readBankConfig(const DatPak::BuildJob &job, DatPak::LogBuffer &report){
+	const fs::path &configFile = job.BankConfig;
+	const fs::path parent = configFile.parent_path();
 	std::error_code errorCode;
-	const fs::file_time_type fileTime = fs::last_write_time(filePath, errorCode);
-	bool modified = programState.force();
+	const fs::file_time_type fileTime = fs::last_write_time(job.Output, errorCode);
+	BankFiles bank;
+	bank.modified = programState.force();
 	if(errorCode){
-		modified = true;
+		bank.modified = true;
 	}
 	auto config = std::ifstream(configFile);
 
-	std::map<uint8_t, fs::path> files;
-	bool issueOccurred = false;
+	auto &files = bank.files;
 
 	while(config.good()){
 		auto peek = config.peek();
@@ -234,43 +390,201 @@ void processVoiceFiles(ConfigState &state, const fs::path &parent, const fs::pat
 		const uint8_t index = std::stoi(indexStr, nullptr, 0);
 		const fs::path sound = parent / soundPathStr;
 		if(!fs::exists(sound)){
-			const std::scoped_lock writeLock{programState.printLock};
-			fmt::print(errorColors, "{} isn't a valid file, skipping\n", sound.string());
-			issueOccurred = true;
-			modified = true;
+			report.print(DatPak::Severity::Error, errorColors, "{} isn't a valid file, skipping\n", sound.string());
+			bank.issueOccurred = true;
+			bank.modified = true;
 			continue;
 		}
 		if(files.contains(index)){
-			const std::scoped_lock writeLock{programState.printLock};
-			fmt::print(errorColors, "Warning: ID '0x{:02X}' is replacing '{}' with '{}'\n",
-			           +index, files[index].string(), soundPathStr);
+			report.print(DatPak::Severity::Warning, errorColors, "Warning: ID '0x{:02X}' is replacing '{}' with '{}'\n",
+			             +index, files[index].string(), soundPathStr);
 		}
 
 		if(fs::last_write_time(sound) > fileTime){
-			modified = true;
+			bank.modified = true;
 		}
 
 		files[index] = sound; // Will overwrite
 		// files.insert({index, sound}); // Doesn't overwrite
 	}
 
-	if(!modified){
-		++state.skipped;
-		return;
+	// The quality tier and trimming change the archive without touching any sound file, so they're checked separately
+	if(!bank.modified && readSettingsStamp(job) != settingsStamp()){
+		report.print(DatPak::Severity::Debug, "Build settings changed since {} was built\n", job.Output.string());
+		bank.modified = true;
 	}
 
-	if(programState.verbose() > 0){
-		const std::scoped_lock writeLock{programState.printLock};
-		fmt::print("Files from '{}': \n", configFile.string());
+	if(DatPak::logSink.enabled(DatPak::Severity::Info)){
+		report.print(DatPak::Severity::Info, "Files from '{}': \n", configFile.string());
 		for(auto &file: files){
-			fmt::print("\t0x{0:02X} ({0:}): {1:}\n", +file.first, file.second.filename().string());
+			report.print(DatPak::Severity::Info, "\t0x{0:02X} ({0:}): {1:}\n", +file.first, file.second.filename().string());
 		}
 	}
 
-	auto &archive = state.archives.emplace_back(datID, std::move(filePath), std::move(files), programState.printLock);
-	if(issueOccurred){
-		archive.incrementWarning();
+	return bank;
+}
+
+fs::path settingsStampPath(const DatPak::BuildJob &job){
+	// Kept apart from the archives, since the output directory is usually copied into the game as a whole
+	return programState.output() / ".datpak" / (DatPak::outputKey(job.Output, programState.output()) + ".settings");
+}
+
+std::string settingsStamp(){
+	std::string stamp;
+	if(programState.quality() == DatPak::Quality::Preview){
+		stamp += "quality preview\n";
+	}
+	if(const auto trim = programState.silenceTrim()){
+		stamp += fmt::format("trim-silence floor {} margin {}\n", trim->floor, trim->marginMs);
+	}
+	return stamp;
+}
+
+std::string readSettingsStamp(const DatPak::BuildJob &job){
+	std::ifstream stamp(settingsStampPath(job));
+	return {std::istreambuf_iterator<char>(stamp), std::istreambuf_iterator<char>()};
+}
+
+void writeSettingsStamp(const DatPak::BuildJob &job){
+	const auto path = settingsStampPath(job);
+	const auto stamp = settingsStamp();
+	if(stamp.empty()){
+		// No stamp means final quality without trimming, which is what every archive built before stamps existed looks like
+		std::error_code errorCode;
+		fs::remove(path, errorCode);
+		return;
+	}
+	fs::create_directories(path.parent_path());
+	std::ofstream stampFile(path);
+	stampFile.exceptions(std::ofstream::badbit | std::ofstream::failbit);
+	stampFile << stamp;
+}
+
+uint64_t shardWeight(const DatPak::BuildJob &job){
+	// Anything wrong with the bank is reported when it's built, by whichever shard gets it.
+	// A bank that can't be read weighs nothing, which every worker agrees on
+	DatPak::LogBuffer report;
+	uint64_t weight = 0;
+	try{
+		for(const auto &[index, file] : readBankConfig(job, report).files){
+			std::error_code errorCode;
+			const auto size = fs::file_size(file, errorCode);
+			if(!errorCode){
+				weight += size;
+			}
+		}
+	}catch(std::exception &){
+		weight = 0;
 	}
+	report.clear();
+	return weight;
+}
 
-	++state.generated;
+void processVoiceFiles(BuildState &state, const DatPak::BuildJob &job, const DatPak::Quality quality, DatPak::ArchiveRecord &record){
+	// Everything about this archive is reported as one block once it's done
+	DatPak::LogBuffer report;
+	// Hashing means reading back every archive that was left alone, so it's only done for --report
+	const bool recording = programState.report().has_value();
+	record.Output = DatPak::outputKey(job.Output, programState.output());
+	record.Tier = quality;
+	try{
+		auto bank = readBankConfig(job, report);
+		if(!bank.modified){
+			// The settings stamp matched, so the archive left alone was built with the requested tier
+			if(quality == DatPak::Quality::Preview){
+				++state.previews;
+			}
+			if(recording){
+				DatPak::hashArchive(job.Output, record);
+			}
+			record.Built = true;
+			++state.skipped;
+			return;
+		}
+
+		auto layout = DatPak::GCAXArchive::plan(job.Output, bank.files, report);
+
+		// Wait until there's room in the memory budget, the reservation is held until the archive is written
+		const auto reservation = programState.memoryBudget.acquire(layout.estimatePeakMemory());
+
+		if(const auto trim = programState.silenceTrim()){
+			DatPak::GCAXArchive::trimSilence(layout, bank.files, *trim, report);
+			report.print(DatPak::Severity::Info, "Trimming silence saved 0x{:X} bytes in {}\n", layout.trimmed_bytes, job.Output.string());
+		}
+
+		DatPak::GCAXArchive archive(job.ID, fs::path(job.Output), std::move(bank.files), layout, quality);
+		if(bank.issueOccurred){
+			archive.incrementWarning();
+		}
+
+		const bool verified = !programState.verify() || archive.verify(layout, programState.verifySnr(), report);
+		if(!verified){
+			archive.incrementWarning(); // Makes sure it's rebuilt next time
+		}
+
+		if(!archive.WriteFile(job.MainConfig, report)){
+			// Whatever is on disk isn't this archive, so it's neither counted nor recorded as built
+			++state.errors;
+			return;
+		}
+		writeSettingsStamp(job);
+		if(recording){
+			record.Size = archive.getData().size();
+			record.Hash = DatPak::fnv1a(archive.getData());
+		}
+		record.Built = true;
+		if(archive.getQuality() == DatPak::Quality::Preview){
+			++state.previews;
+		}
+		if(!verified){
+			++state.failedVerification;
+		}else if(archive.getWarningCount() != 0U){
+			++state.warnings;
+		}else{
+			++state.generated;
+		}
+	}catch(std::exception &err){
+		report.print(DatPak::Severity::Error, errorColors, "{}\n", err.what());
+		++state.errors;
+	}
+}
+
+size_t planVoiceFiles(BuildState &state, const DatPak::BuildJob &job){
+	DatPak::LogBuffer report;
+	try{
+		const auto bank = readBankConfig(job, report);
+		auto layout = DatPak::GCAXArchive::plan(job.Output, bank.files, report);
+		if(const auto trim = programState.silenceTrim()){
+			DatPak::GCAXArchive::trimSilence(layout, bank.files, *trim, report);
+		}
+
+		report.print(DatPak::Severity::Report, "{}: {} bytes, {} entries\n",
+		             job.Output.string(), layout.full_file_length, layout.entries.size());
+		report.print(DatPak::Severity::Report, "\theaders:    0x{:X} bytes (main 0x{:X}, info 0x{:X}, entries 0x{:X})\n",
+		             layout.headerSize(), layout.main_body_size, layout.audio_info_size, layout.file_entry_size);
+		report.print(DatPak::Severity::Report, "\tpadding:    0x{:X} bytes to reach the audio data at 0x{:X}\n",
+		             layout.headerPadding(), layout.audio_data_start_offset);
+		report.print(DatPak::Severity::Report, "\taudio data: 0x{:X} bytes (0x{:X} bytes of alignment)\n",
+		             layout.audio_data_size, layout.entryPadding());
+		report.print(DatPak::Severity::Report, "\ttail:       0x{:X} bytes of padding\n", layout.tailPadding());
+		if(layout.trimmed_bytes != 0U){
+			report.print(DatPak::Severity::Report, "\ttrimmed:    0x{:X} bytes of silence\n", layout.trimmed_bytes);
+		}
+		if(DatPak::logSink.enabled(DatPak::Severity::Info)){
+			for(size_t i = 0; i < layout.entries.size(); i++){
+				const auto &entry = layout.entries[i];
+				report.print(DatPak::Severity::Info, "\t0x{:02X}: {} samples at {} Hz, 0x{:X} bytes at 0x{:X}{}\n",
+				             i, entry.sample_count, entry.sample_rate, entry.adpcm_byte_count,
+				             layout.audio_data_start_offset + entry.offset, entry.substituted ? " (empty sound)" : "");
+			}
+		}
+		if(bank.issueOccurred || layout.warnings != 0U){
+			++state.warnings;
+		}
+		return layout.full_file_length;
+	}catch(std::exception &err){
+		report.print(DatPak::Severity::Error, errorColors, "{}\n", err.what());
+		++state.errors;
+	}
+	return 0;
 }
@@ -1,7 +1,11 @@
 #pragma once
 
+#include <map>
 #include <span>
+#include <string>
 
+#include "buildReport.hpp"
+#include "jobGraph.hpp"
 #include "state.hpp"
 
 namespace fs = std::filesystem;
@@ -12,10 +16,41 @@ enum class return_code : std::int8_t{
 	CxxoptException,
 	FilesystemException,
 	HelpShown,
+	VerificationFailed,
+	ReportMismatch,
+	PlanFailed,
 };
 
 return_code processInput(std::span<const char*> args) noexcept;
 
-void processMainConfigFile(ConfigState &state, const fs::path &config, const fs::path &configParent);
+/// Combines the --report files from every shard of a build, for "DatPak merge-report"
+return_code processMergeReport(std::span<const char*> args) noexcept;
 
-void processVoiceFiles(ConfigState &state, const fs::path &parent, const fs::path &configFile, const uint16_t &datID, fs::path filePath);
\ No newline at end of file
+void processMainConfigFile(BuildState &state, DatPak::JobGraph &jobs, const fs::path &config, const fs::path &configParent);
+
+struct BankFiles{
+	std::map<uint8_t, fs::path> files;
+	bool issueOccurred = false;
+	bool modified = false; // Whether the output is out of date
+};
+
+BankFiles readBankConfig(const DatPak::BuildJob &job, DatPak::LogBuffer &report);
+
+/// Where the --quality and --trim-silence settings an archive was built with are kept,
+/// an archive without one is final quality and wasn't trimmed
+fs::path settingsStampPath(const DatPak::BuildJob &job);
+
+/// The current settings, empty for final quality without trimming
+std::string settingsStamp();
+
+std::string readSettingsStamp(const DatPak::BuildJob &job);
+
+void writeSettingsStamp(const DatPak::BuildJob &job);
+
+/// How much work the job is for --shard, going by the size of its sound files
+uint64_t shardWeight(const DatPak::BuildJob &job);
+
+void processVoiceFiles(BuildState &state, const DatPak::BuildJob &job, DatPak::Quality quality, DatPak::ArchiveRecord &record);
+
+/// Prints the layout the job's archive would have, returning its size
+size_t planVoiceFiles(BuildState &state, const DatPak::BuildJob &job);
\ No newline at end of file
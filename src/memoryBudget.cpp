@@ -0,0 +1,72 @@
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <fmt/core.h>
+
+#include "memoryBudget.hpp"
+
+DatPak::MemoryBudget::Reservation::~Reservation(){
+	if(Budget != nullptr){
+		Budget->release(Bytes);
+	}
+}
+
+void DatPak::MemoryBudget::setLimit(const size_t limit){
+	const std::scoped_lock lock{Lock};
+	Limit = limit;
+}
+
+size_t DatPak::MemoryBudget::getHighWater(){
+	const std::scoped_lock lock{Lock};
+	return HighWater;
+}
+
+DatPak::MemoryBudget::Reservation DatPak::MemoryBudget::acquire(const size_t bytes){
+	std::unique_lock lock{Lock};
+	Released.wait(lock, [&]{
+		return Limit == 0 || InUse == 0 || InUse + bytes <= Limit;
+	});
+	InUse += bytes;
+	HighWater = std::max(HighWater, InUse);
+	return {*this, bytes};
+}
+
+void DatPak::MemoryBudget::release(const size_t bytes){
+	{
+		const std::scoped_lock lock{Lock};
+		InUse -= bytes;
+	}
+	Released.notify_all();
+}
+
+size_t DatPak::parseByteSize(const std::string_view size){
+	size_t value = 0;
+	const auto [end, errorCode] = std::from_chars(size.data(), size.data() + size.size(), value);
+	if(errorCode != std::errc{} || end == size.data()){
+		throw std::invalid_argument(fmt::format("Invalid size \"{}\"", size));
+	}
+
+	const std::string_view suffix(end, size.data() + size.size());
+	size_t shift = 0;
+	if(suffix.empty() || suffix == "B"){
+		shift = 0;
+	}else if(suffix == "K" || suffix == "KB" || suffix == "KiB"){
+		shift = 10; // NOLINT(*-magic-numbers)
+	}else if(suffix == "M" || suffix == "MB" || suffix == "MiB"){
+		shift = 20; // NOLINT(*-magic-numbers)
+	}else if(suffix == "G" || suffix == "GB" || suffix == "GiB"){
+		shift = 30; // NOLINT(*-magic-numbers)
+	}else{
+		throw std::invalid_argument(fmt::format("Unknown size suffix \"{}\" in \"{}\"", suffix, size));
+	}
+	if(value > (std::numeric_limits<size_t>::max() >> shift)){
+		throw std::invalid_argument(fmt::format("Size \"{}\" is too large", size));
+	}
+	return value << shift;
+}
+
+std::string DatPak::formatByteSize(const size_t bytes){
+	constexpr double mebibyte = 1024.0 * 1024.0;
+	return fmt::format("{:.1f} MiB", static_cast<double>(bytes) / mebibyte);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace DatPak {
+	/** Limits how many bytes of archive data may be in flight at once.
+	 *  Archives reserve their estimated peak footprint before they are built and
+	 *  release it once they are written. A limit of 0 means unlimited.
+	 */
+	class MemoryBudget{
+		size_t Limit = 0;
+		size_t InUse = 0;
+		size_t HighWater = 0;
+
+		std::mutex Lock;
+		std::condition_variable Released;
+
+		void release(size_t bytes);
+
+	public:
+		class Reservation{
+			MemoryBudget *Budget;
+			size_t Bytes;
+
+		public:
+			Reservation(MemoryBudget &budget, size_t bytes) : Budget(&budget), Bytes(bytes){}
+			Reservation(const Reservation &) = delete;
+			Reservation &operator=(const Reservation &) = delete;
+			Reservation(Reservation &&other) noexcept : Budget(std::exchange(other.Budget, nullptr)), Bytes(other.Bytes){}
+			Reservation &operator=(Reservation &&) = delete;
+			~Reservation();
+		};
+
+		void setLimit(size_t limit);
+
+		[[nodiscard]] size_t getLimit() const noexcept{ return Limit; }
+
+		[[nodiscard]] size_t getHighWater();
+
+		/** Blocks until the reservation fits in the budget.
+		 *  A reservation larger than the whole budget is admitted once nothing else is in flight.
+		 */
+		[[nodiscard]] Reservation acquire(size_t bytes);
+	};
+
+	/// Parses sizes such as "512M", "4G" or "1048576" into a number of bytes, rejecting sizes that don't fit
+	size_t parseByteSize(std::string_view size);
+
+	std::string formatByteSize(size_t bytes);
+} // namespace DatPak
@@ -0,0 +1,63 @@
+#include <algorithm>
+
+#include "adpcm.hpp"
+#include "silence.hpp"
+
+namespace {
+	constexpr size_t blockSize = 32;
+
+	/// A min/max reduction over int16_t, which compiles down to pminsw/pmaxsw
+	bool blockIsLoud(const std::span<const int16_t> block, const int32_t floor) noexcept{
+		int16_t lowest = 0;
+		int16_t highest = 0;
+		for(const int16_t sample: block){
+			lowest = std::min(lowest, sample);
+			highest = std::max(highest, sample);
+		}
+		return highest > floor || lowest < -floor;
+	}
+
+	bool isLoud(const int16_t sample, const int32_t floor) noexcept{
+		return sample > floor || sample < -floor;
+	}
+} // namespace
+
+DatPak::AudibleRange DatPak::findAudibleRange(const std::span<const int16_t> samples, const uint32_t sampleRate, const SilenceOptions &options) noexcept{
+	const int32_t floor = options.floor;
+	const size_t count = samples.size();
+
+	// Skip whole silent blocks from the front, then find the exact sample
+	size_t first = 0;
+	while(first + blockSize <= count && !blockIsLoud(samples.subspan(first, blockSize), floor)){
+		first += blockSize;
+	}
+	while(first < count && !isLoud(samples[first], floor)){
+		first++;
+	}
+
+	if(first == count){
+		// All silence, keep a single frame so the entry stays valid
+		return {.first_sample = 0, .sample_count = static_cast<uint32_t>(std::min(count, samplesPerFrame))};
+	}
+
+	// Same again from the back
+	size_t end = count;
+	while(end >= first + blockSize && !blockIsLoud(samples.subspan(end - blockSize, blockSize), floor)){
+		end -= blockSize;
+	}
+	while(end > first && !isLoud(samples[end - 1], floor)){
+		end--;
+	}
+
+	constexpr uint64_t millisecondsPerSecond = 1000;
+	const size_t margin = (uint64_t{options.marginMs} * sampleRate) / millisecondsPerSecond;
+	first = first > margin ? first - margin : 0;
+	end = std::min(count, end + margin);
+
+	// Start on a frame boundary and round the length up to whole frames
+	first -= first % samplesPerFrame;
+	const size_t frames = (end - first + samplesPerFrame - 1) / samplesPerFrame;
+	end = std::min(count, first + (frames * samplesPerFrame));
+
+	return {.first_sample = static_cast<uint32_t>(first), .sample_count = static_cast<uint32_t>(end - first)};
+}
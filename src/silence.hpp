@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+
+namespace DatPak {
+	struct SilenceOptions{
+		uint16_t floor; // Samples at or below this amplitude count as silence
+		uint32_t marginMs; // Silence kept on either side of the audible part
+	};
+
+	struct AudibleRange{
+		uint32_t first_sample;
+		uint32_t sample_count;
+	};
+
+	/** Finds the part of the samples above the silence floor, plus the margin on either side.
+	 *  The range starts on an ADPCM frame boundary and covers whole frames where the samples allow it,
+	 *  and always keeps at least one frame.
+	 */
+	AudibleRange findAudibleRange(std::span<const int16_t> samples, uint32_t sampleRate, const SilenceOptions &options) noexcept;
+} // namespace DatPak
@@ -3,17 +3,19 @@
 #include <atomic>
 #include <cxxopts.hpp>
 #include <filesystem>
-#include <list>
-#include <mutex>
+#include <optional>
+#include <stdexcept>
 
 #include "gcaxArchive.hpp"
+#include "jobGraph.hpp"
+#include "memoryBudget.hpp"
 
 namespace fs = std::filesystem;
 
 struct ProgramState{
 	cxxopts::ParseResult result;
 
-	mutable std::mutex printLock;
+	DatPak::MemoryBudget memoryBudget;
 
 	[[nodiscard]] auto verbose() const noexcept{
 		return result["verbose"].count();
@@ -30,15 +32,72 @@ struct ProgramState{
 	[[nodiscard]] const auto& output() const{
 		return result["output"].as<fs::path>();
 	}
+
+	[[nodiscard]] DatPak::Quality quality() const{
+		const auto &quality = result["quality"].as<std::string>();
+		if(quality == "preview"){
+			return DatPak::Quality::Preview;
+		}
+		if(quality == "final"){
+			return DatPak::Quality::Final;
+		}
+		throw std::invalid_argument(fmt::format("Unknown quality \"{}\", expected preview or final", quality));
+	}
+
+	[[nodiscard]] std::optional<DatPak::SilenceOptions> silenceTrim() const{
+		if(result.count("trim-silence") == 0){
+			return std::nullopt;
+		}
+		return DatPak::SilenceOptions{
+				.floor = result["silence-floor"].as<uint16_t>(),
+				.marginMs = result["silence-margin"].as<uint32_t>()
+		};
+	}
+
+	[[nodiscard]] std::optional<DatPak::Shard> shard() const{
+		if(result.count("shard") == 0){
+			return std::nullopt;
+		}
+		return DatPak::parseShard(result["shard"].as<std::string>());
+	}
+
+	[[nodiscard]] std::optional<fs::path> report() const{
+		if(result.count("report") == 0){
+			return std::nullopt;
+		}
+		return result["report"].as<fs::path>();
+	}
+
+	[[nodiscard]] bool verify() const noexcept{
+		return static_cast<bool>(result["verify"].count());
+	}
+
+	[[nodiscard]] double verifySnr() const{
+		return result["verify-snr"].as<double>();
+	}
+
+	[[nodiscard]] size_t maxMemory() const{
+		if(result.count("max-memory") == 0){
+			return 0;
+		}
+		const auto &maxMemory = result["max-memory"].as<std::string>();
+		const size_t limit = DatPak::parseByteSize(maxMemory);
+		if(limit == 0){
+			// 0 is how the budget spells unlimited, which is what leaving the option out already does
+			throw std::invalid_argument(fmt::format("Invalid --max-memory \"{}\", leave it out to not limit memory", maxMemory));
+		}
+		return limit;
+	}
 };
 
 extern ProgramState programState; // NOLINT(*-avoid-non-const-global-variables)
 
-struct ConfigState{
-	std::list<DatPak::GCAXArchive> archives;
-
-	std::atomic<uint_fast8_t> errors = 0;
-	[[maybe_unused]] std::atomic<uint_fast8_t> warnings = 0;
-	std::atomic<uint_fast8_t> generated = 0;
-	std::atomic<uint_fast8_t> skipped = 0;
+struct BuildState{
+	std::atomic<size_t> configErrors = 0; // Every shard reads every config, so these are counted apart from the archives
+	std::atomic<size_t> errors = 0;
+	std::atomic<size_t> warnings = 0;
+	std::atomic<size_t> generated = 0;
+	std::atomic<size_t> skipped = 0;
+	std::atomic<size_t> failedVerification = 0; // Decides the exit code, so it mustn't wrap
+	std::atomic<size_t> previews = 0;
 };
\ No newline at end of file